@@ -1,37 +1,328 @@
 #include <iostream>
 #include <vector>
 #include <omp.h>
-#include <chrono>
 #include <fstream>
 #include <cmath>
-#include <sys/stat.h>
+#include <algorithm>
+#include <functional>
 #include <unistd.h>
 
+#include "bench.h"
+#include "results.h"
+
 double f(double x) {
     return std::sin(x);
 }
 
-void compute_integral(double a, double b, double N, int num_threads, double& result) {
+// Подынтегральная функция передаётся параметром шаблона: лямбда или функтор
+// встраиваются в цикл, в отличие от std::function или указателя на функцию
+template <typename Func>
+void compute_integral(const Func& func, double a, double b, double N, int num_threads, double& result) {
     omp_set_num_threads(num_threads);
 
     const double h = (b - a) / N;
     double local_sum = 0.0;
 
+    #pragma omp parallel for reduction(+:local_sum)
     for (long long i = 0; i < static_cast<long long>(N); ++i) {
         double x_i = a + (i + 0.5) * h;
-        local_sum += f(x_i);
+        local_sum += func(x_i);
     }
 
     result = local_sum * h;
 }
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+void compute_integral(double a, double b, double N, int num_threads, double& result) {
+    compute_integral(f, a, b, N, num_threads, result);
+}
+
+// Векторизуемый sin по схеме Cephes: редукция к [-pi/4, pi/4] по x*4/pi с
+// трёхчленным разбиением pi/4 (Коди–Уэйт) и полиномы 6-й степени для sin и cos.
+// Погрешность полиномов на [-pi/4, pi/4] не превышает 2.2e-16; редукция точна
+// примерно до |x| < 2^30, для больших аргументов нужна редукция Пэйна–Ханека.
+// Фактическая максимальная погрешность на интервале измеряется при запуске
+// (measure_fast_sin_error) и пишется в лог. Ветвлений нет, поэтому цикл с
+// #pragma omp simd компилируется в векторные инструкции
+inline double fast_sin(double x) {
+    const double DP1 = 7.85398125648498535156E-1;
+    const double DP2 = 3.77489470793079817668E-8;
+    const double DP3 = 2.69515142907905952645E-15;
+    const double FOPI = 1.27323954473516268615;
+
+    const double sign_x = std::copysign(1.0, x);
+    x = std::fabs(x);
+
+    int j = static_cast<int>(x * FOPI);
+    j += j & 1;
+    const double y = static_cast<double>(j);
+    // Октанты 4..7 дают тот же модуль со сменой знака
+    const double sign = sign_x * static_cast<double>(1 - ((j >> 1) & 2));
+    j &= 3;
+
+    const double z = ((x - y * DP1) - y * DP2) - y * DP3;
+    const double zz = z * z;
+
+    const double ps = ((((( 1.58962301576546568060E-10 * zz
+                          - 2.50507477628578072866E-8) * zz
+                          + 2.75573136213857245213E-6) * zz
+                          - 1.98412698295895385996E-4) * zz
+                          + 8.33333333332211858878E-3) * zz
+                          - 1.66666666666666307295E-1);
+    const double pc = ((((( -1.13585365213876817300E-11 * zz
+                           + 2.08757008419747316778E-9) * zz
+                           - 2.75573141792967388112E-7) * zz
+                           + 2.48015872888517045348E-5) * zz
+                           - 1.38888888888730564116E-3) * zz
+                           + 4.16666666666665929218E-2);
+
+    const double s_val = z + z * zz * ps;
+    const double c_val = 1.0 - 0.5 * zz + zz * zz * pc;
+    // Выбор без ветвления: флаг равен ровно 0 или 1, поэтому смесь точна
+    const double use_cos = static_cast<double>(((j + 1) >> 1) & 1);
+    return sign * (use_cos * c_val + (1.0 - use_cos) * s_val);
+}
+
+double measure_fast_sin_error(double a, double b, long long samples) {
+    double max_err = 0.0;
+    const double step = (b - a) / static_cast<double>(samples);
+    for (long long i = 0; i < samples; ++i) {
+        const double x = a + (i + 0.5) * step;
+        max_err = std::max(max_err, std::fabs(fast_sin(x) - std::sin(x)));
+    }
+    return max_err;
 }
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+template <typename Func>
+inline double midpoint_sum(const Func& func, double a, double h, long long begin, long long end) {
+    double sum = 0.0;
+    // Внутренний счётчик 32-битный: int64 -> double векторизуется только с AVX-512DQ
+    const long long block = 1LL << 30;
+    for (long long base = begin; base < end; base += block) {
+        const int len = static_cast<int>(std::min(block, end - base));
+        const double x0 = a + (static_cast<double>(base) + 0.5) * h;
+        #pragma omp simd reduction(+:sum)
+        for (int k = 0; k < len; ++k) {
+            sum += func(x0 + static_cast<double>(k) * h);
+        }
+    }
+    return sum;
+}
+
+struct FastSin {
+    double operator()(double x) const { return fast_sin(x); }
+};
+
+// На x86 собираем клоны под AVX2/AVX-512 и выбираем нужный при загрузке,
+// чтобы не зависеть от -march при сборке
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+__attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+double midpoint_sum_chunk(double a, double h, long long begin, long long end) {
+    return midpoint_sum(FastSin(), a, h, begin, end);
+}
+
+// Частичная сумма на поток по непрерывному диапазону, сложение в конце через reduction
+template <typename ChunkSum>
+double sum_over_threads(const ChunkSum& chunk_sum, long long n) {
+    double total = 0.0;
+    #pragma omp parallel reduction(+:total)
+    {
+        const long long nt = omp_get_num_threads();
+        const long long tid = omp_get_thread_num();
+        const long long chunk = (n + nt - 1) / nt;
+        const long long begin = std::min(n, tid * chunk);
+        const long long end = std::min(n, begin + chunk);
+        total = chunk_sum(begin, end);
+    }
+    return total;
+}
+
+template <typename Func>
+void compute_integral_simd(const Func& func, double a, double b, double N, int num_threads, double& result) {
+    omp_set_num_threads(num_threads);
+    const double h = (b - a) / N;
+    const double total = sum_over_threads([&](long long begin, long long end) {
+        return midpoint_sum(func, a, h, begin, end);
+    }, static_cast<long long>(N));
+    result = total * h;
+}
+
+void compute_integral_simd(double a, double b, double N, int num_threads, double& result) {
+    omp_set_num_threads(num_threads);
+    const double h = (b - a) / N;
+    const double total = sum_over_threads([&](long long begin, long long end) {
+        return midpoint_sum_chunk(a, h, begin, end);
+    }, static_cast<long long>(N));
+    result = total * h;
+}
+
+struct QuadratureResult {
+    double value;
+    long long evaluations;
+};
+
+// Адаптивный Симпсон: отрезок делится пополам, пока оценка Ричардсона |S2 - S1| / 15
+// не станет меньше допуска отрезка. Верхние task_levels уровней рекурсии
+// порождают задачи OpenMP, ниже рекурсия идёт последовательно
+template <typename Func>
+double adaptive_simpson(const Func& func, double a, double b, double fa, double fm, double fb, double whole,
+                        double eps, int depth, int task_levels, long long& evals) {
+    const double m = 0.5 * (a + b);
+    const double lm = 0.5 * (a + m);
+    const double rm = 0.5 * (m + b);
+    const double flm = func(lm);
+    const double frm = func(rm);
+    evals += 2;
+
+    const double left = (m - a) / 6.0 * (fa + 4.0 * flm + fm);
+    const double right = (b - m) / 6.0 * (fm + 4.0 * frm + fb);
+    const double delta = left + right - whole;
+    if (depth <= 0 || std::fabs(delta) <= 15.0 * eps) {
+        return left + right + delta / 15.0;
+    }
+
+    double left_value = 0.0;
+    double right_value = 0.0;
+    long long left_evals = 0;
+    long long right_evals = 0;
+    if (task_levels > 0) {
+        #pragma omp task shared(func, left_value, left_evals)
+        left_value = adaptive_simpson(func, a, m, fa, flm, fm, left, 0.5 * eps, depth - 1, task_levels - 1, left_evals);
+        right_value = adaptive_simpson(func, m, b, fm, frm, fb, right, 0.5 * eps, depth - 1, task_levels - 1, right_evals);
+        #pragma omp taskwait
+    } else {
+        left_value = adaptive_simpson(func, a, m, fa, flm, fm, left, 0.5 * eps, depth - 1, 0, left_evals);
+        right_value = adaptive_simpson(func, m, b, fm, frm, fb, right, 0.5 * eps, depth - 1, 0, right_evals);
+    }
+    evals += left_evals + right_evals;
+    return left_value + right_value;
+}
+
+// Что нужно знать о подынтегральной функции для начального разбиения
+struct IntegrandShape {
+    double half_period;   // полупериод колебаний; 0 — функция не осциллирует
+    double smooth_m4;     // оценка |f''''| вне локальных особенностей (их доуточняет рекурсия)
+};
+
+// Начальное число панелей по допуску и свойствам функции, а не по N: панель короче
+// полупериода (иначе три точки Симпсона могут случайно «сойтись») и не шире, чем
+// позволяет ошибка Симпсона на гладкой части, (b - a) * w^4 / 2880 * m4 <= tol
+long long initial_panel_count(double a, double b, double tol, const IntegrandShape& shape) {
+    const double length = b - a;
+    double width = length;
+    if (shape.half_period > 0.0) width = std::min(width, shape.half_period);
+    if (shape.smooth_m4 > 0.0 && tol > 0.0) {
+        width = std::min(width, std::pow(2880.0 * tol / (length * shape.smooth_m4), 0.25));
+    }
+    return std::max(1LL, static_cast<long long>(std::ceil(length / width)));
+}
+
+// Пограничный слой у левого конца: exp(-x / width) / width. Почти весь интеграл набирается
+// в нескольких width от нуля, дальше функция гладкая и почти нулевая — адаптивный метод
+// дробит только слой, а метод прямоугольников тратит вычисления равномерно
+struct BoundaryLayer {
+    double width;
+    double operator()(double x) const { return std::exp(-x / width) / width; }
+    double integral(double a, double b) const { return std::exp(-a / width) - std::exp(-b / width); }
+};
+
+// Число групп панелей (задач верхнего уровня). Не зависит от числа потоков: границы
+// групп задают порядок сложения, и результат одинаков побитно при любом числе потоков
+const long long kAdaptiveGroups = 1024;
+
+// Предел вычислений адаптивного метода относительно N: если уже начальное разбиение
+// (3 точки на панель и 2 на первое деление) дороже, замер пропускается — он шёл бы минуты
+const double kAdaptiveEvalBudget = 32.0;
+
+// [a, b] сначала режется на initial_panels равных панелей (см. initial_panel_count),
+// допуск делится между панелями пропорционально длине.
+// Панели группируются в задачи; если панелей мало, параллелизм даёт рекурсия
+// (задачи рекурсии порядок сложения не меняют)
+template <typename Func>
+QuadratureResult adaptive_integral(const Func& func, double a, double b, double tol, int num_threads,
+                                   long long initial_panels, int max_depth) {
+    omp_set_num_threads(num_threads);
+
+    const long long panels = std::max(1LL, initial_panels);
+    const long long groups = std::min(panels, kAdaptiveGroups);
+    const double width = (b - a) / static_cast<double>(panels);
+    const double panel_tol = tol / static_cast<double>(panels);
+    const int task_levels = (panels >= 8LL * num_threads)
+        ? 0 : static_cast<int>(std::ceil(std::log2(8.0 * num_threads / static_cast<double>(panels)))) + 2;
+
+    std::vector<double> group_values(groups, 0.0);
+    std::vector<long long> group_evals(groups, 0);
+
+    #pragma omp parallel
+    #pragma omp single
+    for (long long g = 0; g < groups; ++g) {
+        #pragma omp task firstprivate(g) shared(group_values, group_evals)
+        {
+            const long long p0 = g * panels / groups;
+            const long long p1 = (g + 1) * panels / groups;
+            double value = 0.0;
+            long long evals = 0;
+            for (long long p = p0; p < p1; ++p) {
+                const double x0 = a + static_cast<double>(p) * width;
+                const double x1 = (p + 1 == panels) ? b : a + static_cast<double>(p + 1) * width;
+                const double fa = func(x0);
+                const double fm = func(0.5 * (x0 + x1));
+                const double fb = func(x1);
+                evals += 3;
+                const double whole = (x1 - x0) / 6.0 * (fa + 4.0 * fm + fb);
+                value += adaptive_simpson(func, x0, x1, fa, fm, fb, whole, panel_tol, max_depth, task_levels, evals);
+            }
+            group_values[g] = value;
+            group_evals[g] = evals;
+        }
+    }
+
+    // Суммируем группы по порядку: вместе с фиксированными границами групп это даёт
+    // один и тот же результат при любом числе потоков
+    QuadratureResult result = { 0.0, 0 };
+    for (long long g = 0; g < groups; ++g) {
+        result.value += group_values[g];
+        result.evaluations += group_evals[g];
+    }
+    return result;
+}
+
+QuadratureResult adaptive_integral(double a, double b, double tol, int num_threads,
+                                   long long initial_panels = 1, int max_depth = 50) {
+    return adaptive_integral(f, a, b, tol, num_threads, initial_panels, max_depth);
+}
+
+// Одно и то же подынтегральное выражение в трёх обёртках: встраиваемая лямбда,
+// std::function и указатель на функцию, спрятанный за volatile от девиртуализации
+struct IntegrandTimes {
+    double templated_ms;
+    double type_erased_ms;
+    double pointer_ms;
+};
+
+template <typename Func>
+double time_integral_simd(const Func& func, double a, double b, double N, int num_threads, const BenchOptions& bench,
+                          ResultWriter& results, const std::string& kernel, const std::string& config) {
+    return results.measure(kernel, config, num_threads, [&] {
+        double res;
+        compute_integral_simd(func, a, b, N, num_threads, res);
+        do_not_optimize(res);
+    }, bench).median;
+}
+
+IntegrandTimes compare_integrand_forms(double a, double b, double N, int num_threads, const BenchOptions& bench,
+                                      ResultWriter& results, const std::string& config) {
+    const auto lambda = [](double x) { return fast_sin(x); };
+    const std::function<double(double)> erased = lambda;
+    double (* volatile pointer_holder)(double) = fast_sin;
+    double (*pointer)(double) = pointer_holder;
+
+    IntegrandTimes times;
+    times.templated_ms = time_integral_simd(lambda, a, b, N, num_threads, bench, results, "integrand_template", config);
+    times.type_erased_ms =
+        time_integral_simd(erased, a, b, N, num_threads, bench, results, "integrand_std_function", config);
+    times.pointer_ms = time_integral_simd(pointer, a, b, N, num_threads, bench, results, "integrand_pointer", config);
+    return times;
 }
 
 int get_available_processors() {
@@ -61,18 +352,7 @@ int main() {
     std::cout << std::endl;
 
     std::string results_dir = "./Results";
-    
-    std::cout << " Проверяем наличие директории Results..." << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << " Создаем директорию Results..." << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cerr << " Ошибка: Не удалось создать директорию Results!\n";
-            return 1;
-        }
-        std::cout << " Директория Results создана успешно" << std::endl;
-    } else {
-        std::cout << " Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
     std::string log_path = results_dir + "/3_log.txt";
     std::ofstream log_file(log_path);
@@ -84,8 +364,30 @@ int main() {
     
     std::cout << " Файл для записи результатов открыт: " << log_path << std::endl;
 
-    const int num_tests = 3;
+    ResultWriter results("3", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
     double base_time = 0.0;
+    double base_time_simd = 0.0;
+
+    // Допуск адаптивного метода для sin — фактическая ошибка метода прямоугольников на том же
+    // интервале, то есть сравнение при равной точности. На целых периодах ошибки метода
+    // прямоугольников взаимно сокращаются, и для sin он почти оптимален: адаптивному методу
+    // здесь нужно больше вычислений, это честный результат, а не настройка
+    const IntegrandShape sin_shape = { M_PI, 1.0 };
+    const BoundaryLayer layer = { 10.0 };
+    const IntegrandShape layer_shape = { 0.0, 0.0 };
+    double adaptive_tol = 0.0;
+    long long adaptive_panels = 1;
+    bool adaptive_run = false;
+    double base_adaptive_value = 0.0;
+    double base_time_adaptive = 0.0;
+
+    const double sin_error = measure_fast_sin_error(a, b_values.back(), 10000000);
+    std::cout << " Погрешность fast_sin на [0, " << b_values.back() << "]: " << sin_error << std::endl;
+    log_file << "fast_sin max abs error on [" << a << ", " << b_values.back() << "]: " << sin_error << "\n";
 
 
 
@@ -97,21 +399,88 @@ int main() {
         std::cout << "   📊 Параметры: N = " << N << ", шаг h = " << h << std::endl;
         
         log_file << "Interval: [" << a << ", " << b << "], N = " << N << ", h = " << h << "\n";
+        const std::string config = "b=" + std::to_string(static_cast<long long>(b)) +
+                                   " n=" + std::to_string(static_cast<long long>(N));
+        results.set_elements(N);
 
         {
             std::cout << "   ⏱️  Выполняем базовый замер (1 поток)..." << std::endl;
-            double total = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
+            base_time = results.measure("midpoint", config, 1, [&] {
                 double res;
-                const auto start = std::chrono::high_resolution_clock::now();
                 compute_integral(a, b, N, 1, res);
-                const auto end = std::chrono::high_resolution_clock::now();
-                total += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            base_time = total / num_tests;
+                do_not_optimize(res);
+            }, bench).median;
             log_file << "Threads: 1\n";
             log_file << "  Time: " << base_time << " ms (speedup: 1x, efficiency: 1)\n";
             std::cout << "    Базовый замер завершен: " << base_time << " мс" << std::endl;
+
+            double res_simd = 0.0;
+            base_time_simd = results.measure("midpoint_simd", config, 1, [&] {
+                compute_integral_simd(a, b, N, 1, res_simd);
+            }, bench).median;
+            log_file << "  SIMD: " << base_time_simd << " ms (speedup: 1x, efficiency: 1, result: " << res_simd << ")\n";
+            std::cout << "    Базовый замер SIMD завершен: " << base_time_simd << " мс" << std::endl;
+
+            double res_mid = 0.0;
+            compute_integral(a, b, N, 1, res_mid);
+            const double exact = std::cos(a) - std::cos(b);
+            adaptive_tol = std::max(std::fabs(res_mid - exact), 1e-12);
+            adaptive_panels = initial_panel_count(a, b, adaptive_tol, sin_shape);
+            const double adaptive_estimate = 5.0 * static_cast<double>(adaptive_panels);
+            adaptive_run = adaptive_estimate <= kAdaptiveEvalBudget * N;
+
+            QuadratureResult adaptive = { 0.0, 0 };
+            if (adaptive_run) {
+                base_time_adaptive = results.measure("adaptive", config, 1, [&] {
+                    adaptive = adaptive_integral(a, b, adaptive_tol, 1, adaptive_panels);
+                }, bench).median;
+                base_adaptive_value = adaptive.value;
+
+                log_file << "  Adaptive: " << base_time_adaptive << " ms (speedup: 1x, efficiency: 1, evaluations: "
+                         << adaptive.evaluations << ", error: " << std::fabs(adaptive.value - exact) << ", tol: "
+                         << adaptive_tol << ", initial panels: " << adaptive_panels << ", evaluation ratio vs midpoint: "
+                         << adaptive.evaluations / N << ")\n";
+            } else {
+                log_file << "  Adaptive: skipped (tol: " << adaptive_tol << ", initial panels: " << adaptive_panels
+                         << ", estimated evaluation ratio vs midpoint: at least " << adaptive_estimate / N
+                         << ", budget: " << kAdaptiveEvalBudget << ")\n";
+            }
+            log_file << "  Midpoint: evaluations: " << static_cast<long long>(N) << ", error: "
+                     << std::fabs(res_mid - exact) << "\n";
+
+            // Пограничный слой: тот же N для метода прямоугольников, допуск адаптивного —
+            // его фактическая ошибка (f'' > 0, сокращения нет). Число вычислений от числа
+            // потоков не зависит, поэтому замер только на одном потоке
+            const double layer_exact = layer.integral(a, b);
+            double layer_mid = 0.0;
+            const double layer_mid_time = results.measure("layer_midpoint", config, 1, [&] {
+                compute_integral(layer, a, b, N, 1, layer_mid);
+            }, bench).median;
+            const double layer_tol = std::max(std::fabs(layer_mid - layer_exact), 1e-12);
+            const long long layer_panels = initial_panel_count(a, b, layer_tol, layer_shape);
+            QuadratureResult layer_adaptive = { 0.0, 0 };
+            const double layer_adaptive_time = results.measure("layer_adaptive", config, 1, [&] {
+                layer_adaptive = adaptive_integral(layer, a, b, layer_tol, 1, layer_panels, 60);
+            }, bench).median;
+            log_file << "  Layer (exp(-x/" << layer.width << ")/" << layer.width << "): midpoint " << layer_mid_time
+                     << " ms (evaluations: " << static_cast<long long>(N) << ", error: "
+                     << std::fabs(layer_mid - layer_exact) << "), adaptive " << layer_adaptive_time
+                     << " ms (evaluations: " << layer_adaptive.evaluations << ", error: "
+                     << std::fabs(layer_adaptive.value - layer_exact) << ", tol: " << layer_tol
+                     << "), evaluation ratio vs midpoint: " << layer_adaptive.evaluations / N << "\n";
+            const IntegrandTimes forms = compare_integrand_forms(a, b, N, 1, bench, results, config);
+            log_file << "  Integrand: template " << forms.templated_ms << " ms, std::function "
+                     << forms.type_erased_ms << " ms, pointer " << forms.pointer_ms << " ms\n";
+
+            if (adaptive_run) {
+                std::cout << "    Адаптивный метод: " << base_time_adaptive << " мс, вычислений f: "
+                          << adaptive.evaluations << " (против " << static_cast<long long>(N) << ")" << std::endl;
+            } else {
+                std::cout << "    Адаптивный метод пропущен: нужно не меньше " << adaptive_estimate
+                          << " вычислений f (против " << static_cast<long long>(N) << ")" << std::endl;
+            }
+            std::cout << "    Пограничный слой: вычислений f адаптивно " << layer_adaptive.evaluations
+                      << " против " << static_cast<long long>(N) << std::endl;
         }
 
         std::cout << "   Начинаем тестирование с разным количеством потоков..." << std::endl;
@@ -120,20 +489,40 @@ int main() {
 
             std::cout << "  Тестируем " << threads << " потоков..." << std::endl;
 
-            double total = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
+            const double avg_time = results.measure("midpoint", config, threads, [&] {
                 double res;
-                const auto start = std::chrono::high_resolution_clock::now();
                 compute_integral(a, b, N, threads, res);
-                const auto end = std::chrono::high_resolution_clock::now();
-                total += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            const double avg_time = total / num_tests;
+                do_not_optimize(res);
+            }, bench).median;
             const double speedup = base_time / avg_time;
             const double efficiency = speedup / threads;
 
             log_file << "Threads: " << threads << "\n";
             log_file << "  Time: " << avg_time << " ms (speedup: " << speedup << "x, efficiency: " << efficiency << ")\n";
+
+            double res_simd = 0.0;
+            const double avg_time_simd = results.measure("midpoint_simd", config, threads, [&] {
+                compute_integral_simd(a, b, N, threads, res_simd);
+            }, bench).median;
+            const double speedup_simd = base_time_simd / avg_time_simd;
+            log_file << "  SIMD: " << avg_time_simd << " ms (speedup: " << speedup_simd << "x, efficiency: "
+                     << speedup_simd / threads << ", result: " << res_simd << ")\n";
+
+            if (adaptive_run) {
+                QuadratureResult adaptive = { 0.0, 0 };
+                const double avg_time_adaptive = results.measure("adaptive", config, threads, [&] {
+                    adaptive = adaptive_integral(a, b, adaptive_tol, threads, adaptive_panels);
+                }, bench).median;
+                const double speedup_adaptive = base_time_adaptive / avg_time_adaptive;
+                log_file << "  Adaptive: " << avg_time_adaptive << " ms (speedup: " << speedup_adaptive
+                         << "x, efficiency: " << speedup_adaptive / threads << ", evaluations: " << adaptive.evaluations
+                         << ", same value as 1 thread: " << (adaptive.value == base_adaptive_value ? "yes" : "no")
+                         << ")\n";
+            }
+
+            const IntegrandTimes forms = compare_integrand_forms(a, b, N, threads, bench, results, config);
+            log_file << "  Integrand: template " << forms.templated_ms << " ms, std::function "
+                     << forms.type_erased_ms << " ms, pointer " << forms.pointer_ms << " ms\n";
             
             std::cout << " " << threads << " потоков: "
                       << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
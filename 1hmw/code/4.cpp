@@ -5,53 +5,326 @@
 #include <fstream>
 #include <random>
 #include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <cstdlib>
 #include <sys/stat.h>
+#include <sys/resource.h>
 
-void compute_max_of_mins(const std::vector<std::vector<int>>& matrix, int num_threads) {
+#include "bench.h"
+#include "results.h"
+#include "matrix.h"
+#include "matrix_file.h"
+
+int compute_max_of_mins(const Matrix& matrix, int num_threads) {
     omp_set_num_threads(num_threads);
 
     int max_of_mins = std::numeric_limits<int>::min();
 
     #pragma omp parallel for reduction(max:max_of_mins)
-    for (int i = 0; i < matrix.size(); ++i) {
+    for (int i = 0; i < static_cast<int>(matrix.rows()); ++i) {
+        const int min_in_row = row_min(matrix.row(i), static_cast<int>(matrix.cols()));
+        if (min_in_row > max_of_mins) max_of_mins = min_in_row;
+    }
+    return max_of_mins;
+}
+
+// Блок строк для отображённого файла: 8 МБ — достаточно крупно для упреждающего
+// чтения с диска и достаточно мелко, чтобы резидентными были лишь 2 блока на поток
+const size_t kMappedBlockBytes = 8 * 1024 * 1024;
+
+// Матрица из файла сканируется блоками строк: блоки раздаются по порядку, для блока,
+// который возьмут следующим, заранее запрашивается чтение (MADV_WILLNEED), а
+// пройденный блок отпускается (MADV_DONTNEED), так что резидентная память ограничена
+int compute_max_of_mins(const MappedMatrix& matrix, int num_threads) {
+    omp_set_num_threads(num_threads);
+
+    const size_t rows = matrix.rows();
+    const int cols = static_cast<int>(matrix.cols());
+    const size_t block_rows = std::max<size_t>(1, kMappedBlockBytes / (matrix.stride() * sizeof(int) + 1));
+    const long long blocks = static_cast<long long>((rows + block_rows - 1) / block_rows);
+
+    int max_of_mins = std::numeric_limits<int>::min();
+
+    #pragma omp parallel reduction(max:max_of_mins)
+    {
+        const long long nt = omp_get_num_threads();
+
+        #pragma omp for schedule(dynamic, 1)
+        for (long long b = 0; b < blocks; ++b) {
+            const size_t r0 = static_cast<size_t>(b) * block_rows;
+            const size_t r1 = std::min(rows, r0 + block_rows);
+            const long long ahead = b + nt;
+            if (ahead < blocks) {
+                const size_t a0 = static_cast<size_t>(ahead) * block_rows;
+                matrix.advise(a0, std::min(rows, a0 + block_rows), MADV_WILLNEED);
+            }
+            for (size_t r = r0; r < r1; ++r) {
+                const int min_in_row = row_min(matrix.row(r), cols);
+                if (min_in_row > max_of_mins) max_of_mins = min_in_row;
+            }
+            matrix.advise(r0, r1, MADV_DONTNEED);
+        }
+    }
+    return max_of_mins;
+}
+
+// Блок, после которого проверяется общая граница: 64 int = 4 кэш-линии,
+// несколько векторных итераций для любого набора инструкций
+const int kPruneBlock = 64;
+
+// Ветви и границы: строка перестаёт сканироваться, как только её текущий минимум
+// опустился до лучшего уже найденного максимума минимумов, — такой строке больше
+// нечего улучшить. Граница общая, читается и обновляется relaxed-атомиками:
+// устаревшее значение лишь ослабляет отсечение, но не меняет ответ
+int compute_max_of_mins_pruned(const Matrix& matrix, int num_threads) {
+    omp_set_num_threads(num_threads);
+
+    std::atomic<int> best(std::numeric_limits<int>::min());
+    const int rows = static_cast<int>(matrix.rows());
+    const int cols = static_cast<int>(matrix.cols());
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        const int* row = matrix.row(i);
         int min_in_row = std::numeric_limits<int>::max();
-        for (int val : matrix[i]) {
-            if (val < min_in_row) min_in_row = val;
+        bool pruned = false;
+        for (int j0 = 0; j0 < cols; j0 += kPruneBlock) {
+            const int j1 = std::min(cols, j0 + kPruneBlock);
+            #pragma omp simd reduction(min:min_in_row)
+            for (int j = j0; j < j1; ++j) {
+                min_in_row = (row[j] < min_in_row) ? row[j] : min_in_row;
+            }
+            if (min_in_row <= best.load(std::memory_order_relaxed)) {
+                pruned = true;
+                break;
+            }
+        }
+        if (!pruned) {
+            int current = best.load(std::memory_order_relaxed);
+            while (min_in_row > current &&
+                   !best.compare_exchange_weak(current, min_in_row, std::memory_order_relaxed)) {
+            }
         }
-        if (min_in_row > max_of_mins) max_of_mins = min_in_row;
     }
+    return best.load(std::memory_order_relaxed);
 }
 
-std::vector<std::vector<int>> generate_matrix(size_t rows, size_t cols, unsigned seed = 42) {
-    std::mt19937 rng(seed);
-    std::uniform_int_distribution<int> dist(-10000, 10000);
+// Счётный генератор: значение элемента — хеш SplitMix64 от (seed, row, col), без
+// состояния, поэтому строки можно порождать в любом порядке и любым числом потоков,
+// а результат от этого не меняется
+inline uint64_t splitmix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-    std::vector<std::vector<int>> mat(rows, std::vector<int>(cols));
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
-            mat[i][j] = dist(rng);
+inline uint64_t procedural_row_key(unsigned seed, uint64_t row) {
+    return splitmix64(splitmix64(seed) ^ (row * 0xD1B54A32D192ED03ULL));
+}
+
+// Равномерно в [-10000, 10000], как у uniform_int_distribution в generate_matrix
+inline int procedural_value(uint64_t row_key, uint64_t col) {
+    const uint64_t z = splitmix64(row_key + (col + 1) * 0x9E3779B97F4A7C15ULL);
+    return static_cast<int>(((z >> 32) * 20001ULL) >> 32) - 10000;
+}
+
+void generate_procedural_row(unsigned seed, size_t row, size_t cols, int* out) {
+    const uint64_t key = procedural_row_key(seed, row);
+    for (size_t j = 0; j < cols; ++j) {
+        out[j] = procedural_value(key, j);
+    }
+}
 
+Matrix generate_matrix_procedural(size_t rows, size_t cols, unsigned seed = 42) {
+    Matrix mat(rows, cols);
+    const long long n = static_cast<long long>(rows);
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < n; ++i) {
+        generate_procedural_row(seed, i, cols, mat.row(i));
+    }
     return mat;
 }
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+// Единица раздачи работы — блок строк общим объёмом ~64К элементов, чтобы на узких
+// матрицах не делить цикл на слишком мелкие итерации
+const size_t kProceduralBlockInts = 64 * 1024;
+
+// Матрица не хранится: каждый поток порождает строку в свой буфер и сразу считает её
+// минимум, пока строка в L1/L2. Пиковая память — одна строка на поток. Буфер — простой
+// вектор, а не Matrix: конструктор Matrix сам размечает страницы параллельным циклом,
+// и внутри параллельной области это была бы вложенная команда потоков
+int compute_max_of_mins_procedural(size_t rows, size_t cols, unsigned seed, int num_threads) {
+    omp_set_num_threads(num_threads);
+
+    const size_t block_rows = std::max<size_t>(1, kProceduralBlockInts / std::max<size_t>(1, cols));
+    const long long blocks = static_cast<long long>((rows + block_rows - 1) / block_rows);
+    const int icols = static_cast<int>(cols);
+
+    int max_of_mins = std::numeric_limits<int>::min();
+
+    #pragma omp parallel reduction(max:max_of_mins)
+    {
+        std::vector<int> row(cols);
+
+        #pragma omp for schedule(static)
+        for (long long b = 0; b < blocks; ++b) {
+            const size_t r0 = static_cast<size_t>(b) * block_rows;
+            const size_t r1 = std::min(rows, r0 + block_rows);
+            for (size_t r = r0; r < r1; ++r) {
+                generate_procedural_row(seed, r, cols, row.data());
+                const int min_in_row = row_min(row.data(), icols);
+                if (min_in_row > max_of_mins) max_of_mins = min_in_row;
+            }
+        }
+    }
+    return max_of_mins;
 }
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+// Сверка: поток строк должен давать тот же ответ, что и материализованная матрица,
+// при любом числе потоков
+bool check_procedural(size_t rows, size_t cols, unsigned seed, int max_threads) {
+    const Matrix mat = generate_matrix_procedural(rows, cols, seed);
+    const int expected = compute_max_of_mins(mat, 1);
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        if (compute_max_of_mins_procedural(rows, cols, seed, threads) != expected) {
+            return false;
+        }
+    }
+    return true;
 }
 
-int main() {
+// Режим --procedural: матрицы не материализуются вовсе, поэтому подходят и размеры больше памяти
+void run_procedural_only(const std::vector<std::pair<int, int>>& sizes, const std::vector<int>& thread_counts,
+                         unsigned seed, const BenchOptions& bench, ResultWriter& results, std::ofstream& log_file) {
+    for (const auto& p : sizes) {
+        const size_t rows = p.first;
+        const size_t cols = p.second;
+        const std::string config = "rows=" + std::to_string(rows) + " cols=" + std::to_string(cols);
+        results.set_elements(static_cast<double>(rows) * cols);
+        log_file << "Matrix: rows = " << rows << ", cols = " << cols
+                 << ", elements = " << static_cast<long long>(rows) * cols << "\n";
+        std::cout << "\n🔧 Потоковая матрица " << rows << "x" << cols << std::endl;
+
+        double base_time = 0.0;
+        for (int threads : thread_counts) {
+            int result = 0;
+            const double avg_time = results.measure("max_of_mins_procedural", config, threads, [&] {
+                result = compute_max_of_mins_procedural(rows, cols, seed, threads);
+            }, bench).median;
+            if (threads == thread_counts.front()) base_time = avg_time;
+            const double speedup = base_time / avg_time;
+
+            log_file << "Threads: " << threads << "\n";
+            log_file << "  Time: " << avg_time << " ms (speedup: " << speedup
+                     << "x, efficiency: " << speedup / threads << ", result: " << result << ")\n";
+            std::cout << "  " << threads << " потоков: " << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
+        }
+        log_file << "--------------------------------------\n";
+    }
+}
+
+double peak_rss_mb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+// Режим --mmap: матрица лежит в файле matrix_<rows>_<cols>.bin (создаётся потоково,
+// если его нет) и сканируется через mmap, без загрузки в память целиком
+bool run_mmap(const std::vector<std::pair<int, int>>& sizes, const std::vector<int>& thread_counts,
+              unsigned seed, const BenchOptions& bench, ResultWriter& results, std::ofstream& log_file) {
+    for (const auto& p : sizes) {
+        const size_t rows = p.first;
+        const size_t cols = p.second;
+        const std::string config = "rows=" + std::to_string(rows) + " cols=" + std::to_string(cols);
+        results.set_elements(static_cast<double>(rows) * cols);
+        const std::string path = "matrix_" + std::to_string(rows) + "_" + std::to_string(cols) + ".bin";
+
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            std::cout << " Создаем файл " << path << "..." << std::endl;
+            if (!write_matrix_file(path, rows, cols, [&](size_t i, int* row) {
+                    generate_procedural_row(seed, i, cols, row);
+                })) {
+                return false;
+            }
+        }
+
+        MappedMatrix matrix;
+        if (!matrix.open(path)) return false;
+        if (matrix.rows() != rows || matrix.cols() != cols) {
+            std::cerr << " Ошибка: в " << path << " матрица " << matrix.rows() << "x" << matrix.cols() << std::endl;
+            return false;
+        }
+
+        const int expected = compute_max_of_mins_procedural(rows, cols, seed, thread_counts.back());
+        log_file << "Matrix: rows = " << rows << ", cols = " << cols
+                 << ", elements = " << static_cast<long long>(rows) * cols << "\n";
+        log_file << "File: " << path << "\n";
+
+        double base_time = 0.0;
+        for (int threads : thread_counts) {
+            int result = 0;
+            const double avg_time = results.measure("max_of_mins_mmap", config, threads, [&] {
+                result = compute_max_of_mins(matrix, threads);
+            }, bench).median;
+            if (result != expected) {
+                std::cerr << " Ошибка: по файлу получено " << result << ", ожидалось " << expected << std::endl;
+                return false;
+            }
+            if (threads == thread_counts.front()) base_time = avg_time;
+            const double speedup = base_time / avg_time;
+            const double gb_per_s = static_cast<double>(rows) * matrix.stride() * sizeof(int) / (avg_time * 1e6);
+
+            log_file << "Threads: " << threads << "\n";
+            log_file << "  Time: " << avg_time << " ms (speedup: " << speedup << "x, efficiency: "
+                     << speedup / threads << ", bandwidth: " << gb_per_s << " GB/s, result: " << result << ")\n";
+            std::cout << "  " << threads << " потоков: " << avg_time << " мс (" << gb_per_s << " ГБ/с)" << std::endl;
+        }
+        log_file << "Peak RSS: " << peak_rss_mb() << " MB\n";
+        log_file << "--------------------------------------\n";
+    }
+    return true;
+}
+
+Matrix generate_matrix(size_t rows, size_t cols, unsigned seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(-10000, 10000);
+
+    Matrix mat(rows, cols);
+    for (size_t i = 0; i < rows; ++i) {
+        int* row = mat.row(i);
+        for (size_t j = 0; j < cols; ++j)
+            row[j] = dist(rng);
+    }
+
+    return mat;
+}
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    const bool procedural_only = mode == "--procedural";
+    const bool mmap_mode = mode == "--mmap";
+
     std::cout << "🔄 Начинаем вычисление максимума из минимумов строк матрицы..." << std::endl;
     
-    const std::vector<std::pair<int, int>> sizes = {
+    std::vector<std::pair<int, int>> sizes = {
         {1000, 1000},
         {5000, 5000},
         {10000, 10000},
         {100000, 10000}
     };
+    // ./4pm --mmap <rows> <cols> — один размер, например больше оперативной памяти
+    if (mmap_mode && argc >= 4) {
+        sizes = { { std::atoi(argv[2]), std::atoi(argv[3]) } };
+    }
 
     const int MAX_THREADS = 12;
     std::vector<int> thread_counts;
@@ -67,20 +340,10 @@ int main() {
     std::cout << "(максимум " << MAX_THREADS << ")" << std::endl;
 
     std::string results_dir = "./Results";
-    
-    std::cout << " Проверяем наличие директории Results..." << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << " Создаем директорию Results..." << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cerr << " Ошибка: Не удалось создать директорию Results!\n";
-            return 1;
-        }
-        std::cout << " Директория Results создана успешно" << std::endl;
-    } else {
-        std::cout << "Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
-    std::string log_path = results_dir + "/4_log.txt";
+    std::string log_path = results_dir + (procedural_only ? "/4_procedural_log.txt"
+                                          : mmap_mode ? "/4_mmap_log.txt" : "/4_log.txt");
     std::ofstream log_file(log_path);
     
     if (!log_file.is_open()) {
@@ -90,11 +353,22 @@ int main() {
     
     std::cout << " Файл для записи результатов открыт: " << log_path << std::endl;
 
-    const int num_tests = 3;
+    ResultWriter results("4", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
     double base_time = 0.0;
+    double base_time_pruned = 0.0;
+    double base_time_procedural = 0.0;
     const unsigned seed = 42;
+
+    if (!check_procedural(300, 517, seed, MAX_THREADS)) {
+        std::cerr << " Ошибка: потоковая генерация расходится с материализованной матрицей!\n";
+        return 1;
+    }
     
     log_file << "Max threads limited to: " << MAX_THREADS << "\n";
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
     log_file << "Threads tested: ";
     for (int t : thread_counts) log_file << t << " ";
     log_file << "\n";
@@ -105,6 +379,20 @@ int main() {
     }
     log_file << "--------------------------------------\n";
 
+    if (procedural_only) {
+        run_procedural_only(sizes, thread_counts, seed, bench, results, log_file);
+        log_file.close();
+        std::cout << " Результаты сохранены в файл: " << log_path << std::endl;
+        return 0;
+    }
+
+    if (mmap_mode) {
+        const bool ok = run_mmap(sizes, thread_counts, seed, bench, results, log_file);
+        log_file.close();
+        std::cout << " Результаты сохранены в файл: " << log_path << std::endl;
+        return ok ? 0 : 1;
+    }
+
     for (const auto& p : sizes) {
         const int rows = p.first;
         const int cols = p.second;
@@ -115,24 +403,49 @@ int main() {
         
         log_file << "Matrix: rows = " << rows << ", cols = " << cols
                  << ", elements = " << total_elements << "\n";
+        const std::string config = "rows=" + std::to_string(rows) + " cols=" + std::to_string(cols);
+        results.set_elements(static_cast<double>(rows) * cols);
 
         std::cout << "    Генерируем матрицу..." << std::endl;
+        const auto gen_start = std::chrono::high_resolution_clock::now();
         auto matrix = generate_matrix(rows, cols, seed);
-        std::cout << "    Матрица сгенерирована" << std::endl;
+        const auto gen_end = std::chrono::high_resolution_clock::now();
+        const double gen_time = std::chrono::duration<double, std::milli>(gen_end - gen_start).count();
+        log_file << "Generation (mt19937, serial): " << gen_time << " ms\n";
+        std::cout << "    Матрица сгенерирована за " << gen_time << " мс" << std::endl;
+
+        // Эталон для отсечения: каждый замерный запуск при любом числе потоков сверяется с ним,
+        // ведь общая граница в relaxed-атомике проверяется по-настоящему только в нескольких потоках
+        const int expected = compute_max_of_mins(matrix, 1);
 
         {
             std::cout << "    Выполняем базовый замер (1 поток)..." << std::endl;
-            double total = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                const auto start = std::chrono::high_resolution_clock::now();
-                compute_max_of_mins(matrix, 1);
-                const auto end = std::chrono::high_resolution_clock::now();
-                total += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            base_time = total / num_tests;
+            base_time = results.measure("max_of_mins", config, 1, [&] {
+                do_not_optimize(compute_max_of_mins(matrix, 1));
+            }, bench).median;
             log_file << "Threads: 1\n";
             log_file << "  Time: " << base_time << " ms (speedup: 1x, efficiency: 1)\n";
             std::cout << "   Базовый замер завершен: " << base_time << " мс" << std::endl;
+
+            int pruned_result = expected;
+            base_time_pruned = results.measure("max_of_mins_pruned", config, 1, [&] {
+                const int result = compute_max_of_mins_pruned(matrix, 1);
+                if (result != expected) pruned_result = result;
+            }, bench).median;
+            if (pruned_result != expected) {
+                std::cerr << " Ошибка: отсечение дало " << pruned_result << ", ожидалось " << expected << std::endl;
+                return 1;
+            }
+            log_file << "  Pruned: " << base_time_pruned << " ms (speedup: 1x, efficiency: 1, result: " << expected << ")\n";
+            std::cout << "   Замер с отсечением: " << base_time_pruned << " мс" << std::endl;
+
+            int procedural_result = 0;
+            base_time_procedural = results.measure("max_of_mins_procedural", config, 1, [&] {
+                procedural_result = compute_max_of_mins_procedural(rows, cols, seed, 1);
+            }, bench).median;
+            log_file << "  Procedural: " << base_time_procedural << " ms (speedup: 1x, efficiency: 1, result: "
+                     << procedural_result << ")\n";
+            std::cout << "   Потоковая генерация + редукция: " << base_time_procedural << " мс" << std::endl;
         }
 
         std::cout << "   Начинаем тестирование с разным количеством потоков..." << std::endl;
@@ -147,20 +460,37 @@ int main() {
 
             std::cout << "  Тестируем " << threads << " потоков..." << std::endl;
 
-            double total = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                const auto start = std::chrono::high_resolution_clock::now();
-                compute_max_of_mins(matrix, threads);
-                const auto end = std::chrono::high_resolution_clock::now();
-                total += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            const double avg_time = total / num_tests;
+            const double avg_time = results.measure("max_of_mins", config, threads, [&] {
+                do_not_optimize(compute_max_of_mins(matrix, threads));
+            }, bench).median;
             const double speedup = base_time / avg_time;
             const double efficiency = speedup / threads;
 
             log_file << "Threads: " << threads << "\n";
             log_file << "  Time: " << avg_time << " ms (speedup: " << speedup
                      << "x, efficiency: " << efficiency << ")" << "\n";
+
+            int pruned_result = expected;
+            const double avg_time_pruned = results.measure("max_of_mins_pruned", config, threads, [&] {
+                const int result = compute_max_of_mins_pruned(matrix, threads);
+                if (result != expected) pruned_result = result;
+            }, bench).median;
+            if (pruned_result != expected) {
+                std::cerr << " Ошибка: отсечение на " << threads << " потоках дало " << pruned_result
+                          << ", ожидалось " << expected << std::endl;
+                return 1;
+            }
+            const double speedup_pruned = base_time_pruned / avg_time_pruned;
+            log_file << "  Pruned: " << avg_time_pruned << " ms (speedup: " << speedup_pruned
+                     << "x, efficiency: " << speedup_pruned / threads << ", result: " << pruned_result << ")\n";
+
+            int procedural_result = 0;
+            const double avg_time_procedural = results.measure("max_of_mins_procedural", config, threads, [&] {
+                procedural_result = compute_max_of_mins_procedural(rows, cols, seed, threads);
+            }, bench).median;
+            const double speedup_procedural = base_time_procedural / avg_time_procedural;
+            log_file << "  Procedural: " << avg_time_procedural << " ms (speedup: " << speedup_procedural
+                     << "x, efficiency: " << speedup_procedural / threads << ", result: " << procedural_result << ")\n";
             
             std::cout << "  " << threads << " потоков: "
                       << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
@@ -1,82 +1,171 @@
 #include <iostream>
 #include <vector>
 #include <omp.h>
-#include <chrono>
 #include <fstream>
 #include <random>
 #include <limits>
 #include <sstream>
 #include <algorithm>
-#include <sys/stat.h>
-#include <unistd.h>
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
-}
+#include "autotune.h"
+#include "bench.h"
+#include "results.h"
+#include "matrix.h"
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+ScheduleConfig schedule_from_name(const std::string& schedule_str)
+{
+    if (schedule_str == "dynamic") return { omp_sched_dynamic, 10 };
+    if (schedule_str == "guided") return { omp_sched_guided, 0 };
+    return { omp_sched_static, 0 };
 }
 
-void compute_max_of_mins(const std::vector<std::vector<int>>& matrix, int num_threads, const std::string& schedule_str)
+int compute_max_of_mins(const Matrix& matrix, int num_threads, const ScheduleConfig& schedule)
 {
     omp_set_num_threads(num_threads);
+    apply_schedule(schedule);
 
-    omp_sched_t sched;
-    int chunk_size = 0;
-    if (schedule_str == "dynamic") {
-        sched = omp_sched_dynamic;
-        chunk_size = 10;
-    }
-    else if (schedule_str == "guided") {
-        sched = omp_sched_guided;
+    int max_of_mins = std::numeric_limits<int>::min();
+
+    #pragma omp parallel for schedule(runtime) reduction(max:max_of_mins)
+    for (int i = 0; i < static_cast<int>(matrix.rows()); ++i) {
+        const int min_in_row = row_min(matrix.row(i), static_cast<int>(matrix.cols()));
+        if (min_in_row > max_of_mins) max_of_mins = min_in_row;
     }
-    else {
-        sched = omp_sched_static;
+    return max_of_mins;
+}
+
+// Компактные форматы: сканируются только хранимые элементы строки
+int compute_max_of_mins(const BandMatrix& matrix, int num_threads, const ScheduleConfig& schedule)
+{
+    omp_set_num_threads(num_threads);
+    apply_schedule(schedule);
+
+    int max_of_mins = std::numeric_limits<int>::min();
+
+    #pragma omp parallel for schedule(runtime) reduction(max:max_of_mins)
+    for (int i = 0; i < static_cast<int>(matrix.size()); ++i) {
+        const int len = static_cast<int>(matrix.col_end(i) - matrix.col_begin(i));
+        const int min_in_row = row_min(matrix.row(i), len);
+        if (min_in_row > max_of_mins) max_of_mins = min_in_row;
     }
-    omp_set_schedule(sched, chunk_size);
+    return max_of_mins;
+}
+
+int compute_max_of_mins(const PackedLowerMatrix& matrix, int num_threads, const ScheduleConfig& schedule)
+{
+    omp_set_num_threads(num_threads);
+    apply_schedule(schedule);
 
     int max_of_mins = std::numeric_limits<int>::min();
 
     #pragma omp parallel for schedule(runtime) reduction(max:max_of_mins)
-    for (int i = 0; i < matrix.size(); ++i) {
-        int min_in_row = std::numeric_limits<int>::max();
-        for (int val : matrix[i]) {
-            if (val < min_in_row) min_in_row = val;
-        }
+    for (int i = 0; i < static_cast<int>(matrix.size()); ++i) {
+        const int min_in_row = row_min(matrix.row(i), static_cast<int>(matrix.row_length(i)));
         if (min_in_row > max_of_mins) max_of_mins = min_in_row;
     }
+    return max_of_mins;
+}
+
+// Профиль автоподбора лежит рядом с логами; создаётся при первом обращении
+ScheduleTuner& schedule_tuner()
+{
+    static ScheduleTuner tuner("./Results/autotune_profile.txt");
+    return tuner;
 }
 
-std::vector<std::vector<int>> generate_banded(size_t n, int k, unsigned seed = 42) {
+std::string shape_key(const Matrix& m) { return "dense_" + std::to_string(m.rows()) + "x" + std::to_string(m.cols()); }
+std::string shape_key(const BandMatrix& m) { return "band_" + std::to_string(m.size()) + "_k" + std::to_string(m.bandwidth()); }
+std::string shape_key(const PackedLowerMatrix& m) { return "lower_" + std::to_string(m.size()); }
+
+// "auto" — схема из профиля для этого хоста, формы матрицы и числа потоков;
+// если записи нет, она подбирается пробными запусками и сохраняется.
+// Без явной схемы compute_max_of_mins тоже берёт её из профиля
+template <typename AnyMatrix>
+ScheduleConfig resolve_schedule(const AnyMatrix& matrix, int num_threads, const std::string& schedule_str)
+{
+    if (schedule_str != "auto") return schedule_from_name(schedule_str);
+    return schedule_tuner().resolve("max_of_mins", shape_key(matrix), num_threads, [&](const ScheduleConfig& config) {
+        compute_max_of_mins(matrix, num_threads, config);
+    });
+}
+
+template <typename AnyMatrix>
+int compute_max_of_mins(const AnyMatrix& matrix, int num_threads, const std::string& schedule_str = "auto")
+{
+    return compute_max_of_mins(matrix, num_threads, resolve_schedule(matrix, num_threads, schedule_str));
+}
+
+Matrix generate_banded(size_t n, int k, unsigned seed = 42) {
     std::mt19937 rng(seed);
     std::uniform_int_distribution<int> dist(-10000, 10000);
 
-    std::vector<std::vector<int>> mat(n, std::vector<int>(n, std::numeric_limits<int>::max()));
+    Matrix mat(n, n, std::numeric_limits<int>::max());
     for (size_t i = 0; i < n; ++i) {
+        int* row = mat.row(i);
         int start = std::max(0, static_cast<int>(i) - k);
         int end = std::min(static_cast<int>(n) - 1, static_cast<int>(i) + k);
         for (int j = start; j <= end; ++j) {
-            mat[i][j] = dist(rng);
+            row[j] = dist(rng);
         }
     }
     return mat;
 }
 
-std::vector<std::vector<int>> generate_lower_triangular(size_t n, unsigned seed = 42) {
+Matrix generate_lower_triangular(size_t n, unsigned seed = 42) {
     std::mt19937 rng(seed);
     std::uniform_int_distribution<int> dist(-10000, 10000);
 
-    std::vector<std::vector<int>> mat(n, std::vector<int>(n, std::numeric_limits<int>::max()));
+    Matrix mat(n, n, std::numeric_limits<int>::max());
     for (size_t i = 0; i < n; ++i) {
+        int* row = mat.row(i);
         for (size_t j = 0; j <= i; ++j) {
-            mat[i][j] = dist(rng);
+            row[j] = dist(rng);
         }
     }
     return mat;
 }
 
+// Те же значения в том же порядке генератора, что и generate_banded / generate_lower_triangular
+BandMatrix generate_banded_compact(size_t n, int k, unsigned seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(-10000, 10000);
+
+    BandMatrix mat(n, k);
+    for (size_t i = 0; i < n; ++i) {
+        int* row = mat.row(i);
+        const size_t len = mat.col_end(i) - mat.col_begin(i);
+        for (size_t j = 0; j < len; ++j) {
+            row[j] = dist(rng);
+        }
+    }
+    return mat;
+}
+
+PackedLowerMatrix generate_lower_packed(size_t n, unsigned seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(-10000, 10000);
+
+    PackedLowerMatrix mat(n);
+    for (size_t i = 0; i < n; ++i) {
+        int* row = mat.row(i);
+        for (size_t j = 0; j <= i; ++j) {
+            row[j] = dist(rng);
+        }
+    }
+    return mat;
+}
+
+// Время компактного формата на заданной схеме планирования
+template <typename CompactMatrix>
+double time_compact(const CompactMatrix& matrix, int num_threads, const std::string& schedule,
+                    const BenchOptions& bench, ResultWriter& results, const std::string& shape)
+{
+    const ScheduleConfig config = resolve_schedule(matrix, num_threads, schedule);
+    return results.measure("max_of_mins_compact", shape + " schedule=" + schedule, num_threads, [&] {
+        do_not_optimize(compute_max_of_mins(matrix, num_threads, config));
+    }, bench).median;
+}
+
 int main()
 {
     std::cout << " Запуск программы для тестирования разных типов матриц и стратегий планирования...\n";
@@ -85,7 +174,7 @@ int main()
     const std::vector<std::string> matrix_types = { "banded", "lower" };
     // Базовый список, который будет отфильтрован
     const std::vector<int> thread_counts_all = { 1, 2, 4, 6, 8, 12, 16, 32 };
-    const std::vector<std::string> schedules = { "static", "dynamic", "guided" };
+    const std::vector<std::string> schedules = { "static", "dynamic", "guided", "auto" };
 
     // Фильтруем потокы: оставляем только те, что <= 12
     std::vector<int> thread_counts;
@@ -102,17 +191,7 @@ int main()
 
     std::string results_dir = "./Results";
 
-    std::cout << " Проверяем наличие директории '" << results_dir << "'...\n";
-    if (!directory_exists(results_dir)) {
-        std::cout << " Директория не найдена. Создаем...\n";
-        if (!create_directory(results_dir)) {
-            std::cerr << " Ошибка: Не удалось создать директорию Results!\n";
-            return 1;
-        }
-        std::cout << " Директория успешно создана.\n";
-    } else {
-        std::cout << " Директория уже существует.\n";
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
     std::string log_path = results_dir + "/5_log.txt";
     std::ofstream log_file(log_path);
@@ -124,9 +203,22 @@ int main()
 
     std::cout << " Файл для записи результатов открыт: " << log_path << "\n\n";
 
-    const int num_tests = 3;
+    ResultWriter results("5", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
     const unsigned seed = 42;
 
+    // Счётчики снимает общий замер (ResultWriter::measure); если их нет, это видно
+    // один раз в заголовке лога, а замеры идут как обычно
+    const bool counters = results.counters_available();
+    if (counters) {
+        log_file << "Counters: per-thread perf_event_open, one extra run per configuration, per element = n*n\n";
+    } else {
+        log_file << "Counters: " << results.counters_summary() << "\n";
+    }
+
     for (const auto& type : matrix_types) {
         std::cout << "==============================\n";
         std::cout << " Начинаем тестирование для типа матрицы: " << type << "\n";
@@ -136,33 +228,55 @@ int main()
             std::cout << " Размер матрицы: " << n << "x" << n << " ("
                       << (static_cast<long long>(n) * n) << " элементов)\n";
 
-            std::vector<std::vector<int>> matrix;
+            Matrix matrix;
+            BandMatrix band;
+            PackedLowerMatrix packed;
             int k = 0;
+            size_t compact_bytes = 0;
+            int compact_result = 0;
 
             std::cout << "    Генерация матрицы... ";
             if (type == "banded") {
                 k = n / 10;
                 matrix = generate_banded(n, k, seed);
+                band = generate_banded_compact(n, k, seed);
+                compact_bytes = band.bytes();
+                compact_result = compute_max_of_mins(band, 1, "static");
                 std::cout << "ленточная (k=" << k << ")\n";
             }
             else if (type == "lower") {
                 matrix = generate_lower_triangular(n, seed);
+                packed = generate_lower_packed(n, seed);
+                compact_bytes = packed.bytes();
+                compact_result = compute_max_of_mins(packed, 1, "static");
                 std::cout << "нижняя треугольная\n";
             }
 
+            const size_t dense_bytes = matrix.rows() * matrix.stride() * sizeof(int);
+            if (compute_max_of_mins(matrix, 1, "static") != compact_result) {
+                std::cerr << " Ошибка: компактный формат дал другой результат!\n";
+                return 1;
+            }
+            const std::string shape = "n=" + std::to_string(n) + " type=" + type;
+            results.set_elements(static_cast<double>(n) * n);
+            auto compact_time = [&](int threads, const std::string& schedule) {
+                return (type == "banded") ? time_compact(band, threads, schedule, bench, results, shape)
+                                          : time_compact(packed, threads, schedule, bench, results, shape);
+            };
+
             double base_time = 0.0;
             {
                 std::cout << "    Базовый замер (1 поток, static schedule)... ";
-                double total = 0.0;
-                for (int t = 0; t < num_tests; ++t) {
-                    const auto start = std::chrono::high_resolution_clock::now();
-                    compute_max_of_mins(matrix, 1, "static");
-                    const auto end = std::chrono::high_resolution_clock::now();
-                    total += std::chrono::duration<double, std::milli>(end - start).count();
-                }
-                base_time = total / num_tests;
+                base_time = results.measure("max_of_mins", shape + " schedule=static", 1, [&] {
+                    do_not_optimize(compute_max_of_mins(matrix, 1, "static"));
+                }, bench).median;
                 std::cout << base_time << " мс\n";
             }
+            const std::string base_counters = results.counters_summary();
+            const double base_time_compact = compact_time(1, "static");
+            const std::string base_compact_counters = results.counters_summary();
+            std::cout << "    Компактный формат (1 поток): " << base_time_compact << " мс, память "
+                      << compact_bytes / 1048576.0 << " МБ против " << dense_bytes / 1048576.0 << " МБ\n";
 
             for (const auto& schedule : schedules) {
                 std::cout << "   Стратегия планирования: " << schedule << "\n";
@@ -174,25 +288,34 @@ int main()
 
                 log_file << "Threads: 1\n";
                 log_file << "  Time: " << base_time << " ms (speedup: 1x, efficiency: 1)\n";
+                if (counters) log_file << "  Counters: " << base_counters << "\n";
+                log_file << "  Compact: " << base_time_compact << " ms (speedup: 1x, efficiency: 1, memory: "
+                         << compact_bytes << " bytes vs " << dense_bytes << " bytes)\n";
+                if (counters) log_file << "  Compact counters: " << base_compact_counters << "\n";
 
                 for (int threads : thread_counts) {
                     if (threads == 1) continue;
 
                     std::cout << "       Потоков: " << threads << "... ";
-                    double total = 0.0;
-                    for (int t = 0; t < num_tests; ++t) {
-                        const auto start = std::chrono::high_resolution_clock::now();
-                        compute_max_of_mins(matrix, threads, schedule);
-                        const auto end = std::chrono::high_resolution_clock::now();
-                        total += std::chrono::duration<double, std::milli>(end - start).count();
-                    }
-                    const double avg_time = total / num_tests;
+                    // Подбор для "auto" (если профиля ещё нет) — вне замера
+                    const ScheduleConfig config = resolve_schedule(matrix, threads, schedule);
+                    const double avg_time = results.measure("max_of_mins", shape + " schedule=" + schedule, threads, [&] {
+                        do_not_optimize(compute_max_of_mins(matrix, threads, config));
+                    }, bench).median;
                     const double speedup = base_time / avg_time;
                     const double efficiency = speedup / threads;
 
                     log_file << "Threads: " << threads << "\n";
                     log_file << "  Time: " << avg_time << " ms (speedup: "
                              << speedup << "x, efficiency: " << efficiency << ")\n";
+                    if (counters) log_file << "  Counters: " << results.counters_summary() << "\n";
+                    if (schedule == "auto") log_file << "  Tuned: " << describe_schedule(config) << "\n";
+
+                    const double avg_time_compact = compact_time(threads, schedule);
+                    const double speedup_compact = base_time_compact / avg_time_compact;
+                    log_file << "  Compact: " << avg_time_compact << " ms (speedup: " << speedup_compact
+                             << "x, efficiency: " << speedup_compact / threads << ")\n";
+                    if (counters) log_file << "  Compact counters: " << results.counters_summary() << "\n";
 
                     std::cout << avg_time << " мс (ускорение: " << speedup << "x)\n";
                 }
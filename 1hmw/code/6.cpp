@@ -1,45 +1,124 @@
 #include <iostream>
 #include <vector>
 #include <omp.h>
-#include <chrono>
 #include <fstream>
 #include <random>
 #include <cmath>
-#include <sys/stat.h>
 
-void test_schedule(const std::vector<int>& a, int num_threads, const std::string& schedule_type) {
-    omp_set_num_threads(num_threads);
+#include "autotune.h"
+#include "bench.h"
+#include "results.h"
+#include "worksteal.h"
+
+// Нерегулярная нагрузка на элемент: a[i] % 1000 вычислений sin
+inline double element_work(int value) {
+    int work = value % 1000;
+    double local_sum = 0.0;
+    for (int j = 0; j < work; ++j) {
+        local_sum += std::sin(j * 0.001);
+    }
+    return local_sum;
+}
+
+const int kWorkLevels = 1000;
+
+// prefix[w] = sum_{j<w} sin(j * 0.001). Слагаемые считаются параллельно, а складываются
+// последовательно в том же порядке, что и в element_work, поэтому prefix[a % 1000]
+// побитово совпадает с element_work(a)
+std::vector<double> build_sin_prefix_table(int num_threads) {
+    std::vector<double> terms(kWorkLevels);
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int j = 0; j < kWorkLevels; ++j) {
+        terms[j] = std::sin(j * 0.001);
+    }
+    std::vector<double> prefix(kWorkLevels);
+    double running = 0.0;
+    for (int w = 0; w < kWorkLevels; ++w) {
+        prefix[w] = running;
+        running += terms[w];
+    }
+    return prefix;
+}
 
-    if (schedule_type == "static")
-        omp_set_schedule(omp_sched_static, 0);
-    else if (schedule_type == "dynamic")
-        omp_set_schedule(omp_sched_dynamic, 5);
-    else if (schedule_type == "guided")
-        omp_set_schedule(omp_sched_guided, 0);
+// Ядро с вычислениями (упирается в sin) и ядро с таблицей (упирается в чтение a)
+struct ComputeKernel {
+    static const char* name() { return "sin_work"; }
+    double operator()(int value) const { return element_work(value); }
+};
+
+struct CachedKernel {
+    const double* prefix;
+    static const char* name() { return "sin_table"; }
+    double operator()(int value) const { return prefix[value % kWorkLevels]; }
+};
+
+template <typename Kernel>
+double test_schedule(const int* a, int n, int num_threads, const ScheduleConfig& schedule, const Kernel& kernel) {
+    omp_set_num_threads(num_threads);
+    apply_schedule(schedule);
 
     double sum = 0.0;
 
     #pragma omp parallel for schedule(runtime) reduction(+:sum)
-    for (int i = 0; i < (int)a.size(); ++i) {
-        int work = a[i] % 1000;
-        double local_sum = 0.0;
-        for (int j = 0; j < work; ++j) {
-            local_sum += std::sin(j * 0.001);
-        }
-        sum += local_sum;
+    for (int i = 0; i < n; ++i) {
+        sum += kernel(a[i]);
     }
+    return sum;
 }
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+template <typename Kernel>
+double test_schedule(const std::vector<int>& a, int num_threads, const ScheduleConfig& schedule, const Kernel& kernel) {
+    return test_schedule(a.data(), static_cast<int>(a.size()), num_threads, schedule, kernel);
 }
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+// Тот же цикл на деках с кражей работы; порция та же, что у dynamic
+const long long kStealGrain = 5;
+
+template <typename Kernel>
+double test_worksteal(const std::vector<int>& a, int num_threads, const Kernel& kernel, WorkStealStats* stats = nullptr) {
+    return worksteal_sum(0, static_cast<long long>(a.size()), num_threads, kStealGrain,
+        [&](long long lo, long long hi) {
+            double local_sum = 0.0;
+            for (long long i = lo; i < hi; ++i) local_sum += kernel(a[i]);
+            return local_sum;
+        }, stats);
 }
 
-int main() {
+// Пробный прогон автоподбора идёт на префиксе вектора (без копии): нагрузка по элементам
+// случайна и равномерна, так что префикс представителен, а подбор короткий
+const size_t kTunePilotSize = 20000;
+
+ScheduleTuner& schedule_tuner() {
+    static ScheduleTuner tuner("./Results/autotune_profile.txt");
+    return tuner;
+}
+
+// "auto" — схема из профиля для этого хоста, ядра, размера и числа потоков;
+// если записи нет, она подбирается пробными запусками и сохраняется
+template <typename Kernel>
+ScheduleConfig resolve_schedule(const std::vector<int>& a, int num_threads, const std::string& schedule_type,
+                                const Kernel& kernel) {
+    if (schedule_type == "dynamic") return { omp_sched_dynamic, 5 };
+    if (schedule_type == "guided") return { omp_sched_guided, 0 };
+    if (schedule_type != "auto") return { omp_sched_static, 0 };
+
+    const int pilot = static_cast<int>(std::min(a.size(), kTunePilotSize));
+    return schedule_tuner().resolve(Kernel::name(), "n" + std::to_string(a.size()), num_threads,
+        [&](const ScheduleConfig& config) { test_schedule(a.data(), pilot, num_threads, config, kernel); });
+}
+
+// Один прогон цикла по имени стратегии; для OpenMP-стратегий config уже разрешён
+template <typename Kernel>
+double run_schedule(const std::vector<int>& a, int num_threads, const std::string& schedule_type,
+                    const ScheduleConfig& config, const Kernel& kernel, WorkStealStats* stats = nullptr) {
+    if (schedule_type == "worksteal") return test_worksteal(a, num_threads, kernel, stats);
+    return test_schedule(a, num_threads, config, kernel);
+}
+
+int main(int argc, char** argv) {
+    // ./6 --cached — то же сравнение стратегий, но с ядром-таблицей вместо счёта sin
+    const bool cached = argc > 1 && std::string(argv[1]) == "--cached";
+
     std::cout << "Начинаем тестирование стратегий планирования OpenMP" << std::endl;
     
     std::random_device rd;
@@ -48,7 +127,7 @@ int main() {
 
     std::vector<int> thread_counts = { 1, 2, 4, 6, 8, 12 };
     std::vector<size_t> sizes = { 10000, 100000, 500000 };
-    std::vector<std::string> schedules = { "static", "dynamic", "guided" };
+    std::vector<std::string> schedules = { "static", "dynamic", "guided", "auto", "worksteal" };
 
     std::cout << "Тестируемые количества потоков: ";
     for (int t : thread_counts) std::cout << t << " ";
@@ -63,20 +142,9 @@ int main() {
     std::cout << std::endl;
 
     std::string results_dir = "./Results";
-    
-    std::cout << "Проверяем наличие директории Results" << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << "Создаем директорию Results" << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cerr << "Ошибка: Не удалось создать директорию Results" << std::endl;
-            return 1;
-        }
-        std::cout << "Директория Results создана успешно" << std::endl;
-    } else {
-        std::cout << "Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
-    std::string log_path = results_dir + "/6_log.txt";
+    std::string log_path = results_dir + (cached ? "/6_cached_log.txt" : "/6_log.txt");
     std::ofstream log_file(log_path);
     
     if (!log_file.is_open()) {
@@ -86,9 +154,23 @@ int main() {
     
     std::cout << "Файл для записи результатов открыт: " << log_path << std::endl;
 
-    const int num_tests = 3;
+    ResultWriter results("6", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
+
+    const std::vector<double> prefix_table = build_sin_prefix_table(thread_counts.back());
+    const ComputeKernel compute_kernel;
+    const CachedKernel cached_kernel = { prefix_table.data() };
+    const std::string kernel = cached ? CachedKernel::name() : ComputeKernel::name();
+    auto resolve = [&](const std::vector<int>& a, int threads, const std::string& schedule) {
+        return cached ? resolve_schedule(a, threads, schedule, cached_kernel)
+                      : resolve_schedule(a, threads, schedule, compute_kernel);
+    };
 
     log_file << "OpenMP Schedule Testing\n";
+    log_file << "Kernel: " << (cached ? CachedKernel::name() : ComputeKernel::name()) << "\n";
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
     log_file << "Threads tested: ";
     for (int t : thread_counts) log_file << t << " ";
     log_file << "\nVector sizes: ";
@@ -108,26 +190,45 @@ int main() {
         }
         std::cout << "Данные сгенерированы" << std::endl;
 
+        // Таблица совпадает с прямым счётом поэлементно, так что однопоточные суммы равны;
+        // кража работы меняет порядок сложения, поэтому сверяем с точностью до округления
+        const ScheduleConfig serial = { omp_sched_static, 0 };
+        const double reference = test_schedule(a, 1, serial, compute_kernel);
+        if (cached && test_schedule(a, 1, serial, cached_kernel) != reference) {
+            std::cerr << "Ошибка: ядро-таблица разошлось с прямым счётом" << std::endl;
+            return 1;
+        }
+        const double stolen = cached ? test_worksteal(a, thread_counts.back(), cached_kernel)
+                                     : test_worksteal(a, thread_counts.back(), compute_kernel);
+        if (std::fabs(stolen - reference) > 1e-9 * std::fabs(reference)) {
+            std::cerr << "Ошибка: worksteal дал " << stolen << " вместо " << reference << std::endl;
+            return 1;
+        }
+
         for (const auto& schedule : schedules) {
             std::cout << "Тестируем стратегию: " << schedule << std::endl;
+            WorkStealStats stats = { 0 };
+            auto run = [&](int threads, const ScheduleConfig& config) {
+                const double sum = cached ? run_schedule(a, threads, schedule, config, cached_kernel, &stats)
+                                          : run_schedule(a, threads, schedule, config, compute_kernel, &stats);
+                do_not_optimize(sum);
+            };
             
             log_file << "Vector size: " << size << "\n";
             log_file << "Schedule: " << schedule << "\n";
+            const std::string params = "size=" + std::to_string(size) + " schedule=" + schedule;
+            results.set_elements(static_cast<double>(size));
 
             std::cout << "Базовый замер (1 поток)" << std::endl;
-            double total_time = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                auto start = std::chrono::high_resolution_clock::now();
-                test_schedule(a, 1, schedule);
-                auto end = std::chrono::high_resolution_clock::now();
-                total_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            double base_time = total_time / num_tests;
+            // Подбор для "auto" (если профиля ещё нет) — вне замера
+            ScheduleConfig config = resolve(a, 1, schedule);
+            double base_time = results.measure(kernel, params, 1, [&] { run(1, config); }, bench).median;
             double speedup = 1.0;
             double efficiency = 1.0;
             
             log_file << "Threads: 1\n";
             log_file << " Time: " << base_time << " ms (speedup: " << speedup << "x, efficiency: " << efficiency << ")\n";
+            if (schedule == "auto") log_file << " Tuned: " << describe_schedule(config) << "\n";
             
             std::cout << "Базовый замер: " << base_time << " мс" << std::endl;
 
@@ -137,19 +238,15 @@ int main() {
 
                 std::cout << "Тестируем " << threads << " потоков" << std::endl;
                 
-                total_time = 0.0;
-                for (int t = 0; t < num_tests; ++t) {
-                    auto start = std::chrono::high_resolution_clock::now();
-                    test_schedule(a, threads, schedule);
-                    auto end = std::chrono::high_resolution_clock::now();
-                    total_time += std::chrono::duration<double, std::milli>(end - start).count();
-                }
-                double avg_time = total_time / num_tests;
+                config = resolve(a, threads, schedule);
+                double avg_time = results.measure(kernel, params, threads, [&] { run(threads, config); }, bench).median;
                 speedup = base_time / avg_time;
                 efficiency = speedup / threads;
                 
                 log_file << "Threads: " << threads << "\n";
                 log_file << " Time: " << avg_time << " ms (speedup: " << speedup << "x, efficiency: " << efficiency << ")\n";
+                if (schedule == "auto") log_file << " Tuned: " << describe_schedule(config) << "\n";
+                if (schedule == "worksteal") log_file << " Steals: " << stats.steals << " (last run)\n";
                 
                 std::cout << threads << " потоков: " << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
             }
@@ -1,12 +1,23 @@
 #include <iostream>
 #include <vector>
 #include <omp.h>
-#include <chrono>
 #include <fstream>
 #include <random>
-#include <sys/stat.h>
+#include <cmath>
+#include <map>
 
-void test_reduction_method(const std::vector<double>& a, int num_threads, const std::string& method) {
+#include "bench.h"
+#include "results.h"
+#include "deterministic_sum.h"
+
+// Слот частичной суммы на отдельной кэш-линии: соседние потоки никогда не пишут
+// в одну линию, поэтому ложного разделения нет по построению
+struct alignas(64) PaddedDouble {
+    double value;
+};
+static_assert(sizeof(PaddedDouble) == 64 && alignof(PaddedDouble) == 64, "slot must occupy exactly one cache line");
+
+double test_reduction_method(const std::vector<double>& a, int num_threads, const std::string& method) {
     omp_set_num_threads(num_threads);
 
     double sum = 0.0;
@@ -42,15 +53,63 @@ void test_reduction_method(const std::vector<double>& a, int num_threads, const
         }
         omp_destroy_lock(&lock);
     }
-}
-
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
-}
-
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+    else if (method == "padded") {
+        // Каждый поток копит в регистре и один раз пишет итог в свой слот, слоты складывает
+        // один поток. Копить прямо в слоте нельзя: компилятор не докажет, что слот не
+        // пересекается с a, и будет сохранять его в память на каждой итерации
+        std::vector<PaddedDouble> slots(num_threads, PaddedDouble{ 0.0 });
+        #pragma omp parallel
+        {
+            double local = 0.0;
+            #pragma omp for schedule(static)
+            for (size_t i = 0; i < a.size(); ++i) {
+                local += a[i];
+            }
+            slots[omp_get_thread_num()].value = local;
+        }
+        for (const PaddedDouble& slot : slots) sum += slot.value;
+    }
+    else if (method == "tree") {
+        // Слоты сливаются попарно за log2(p) шагов с барьером между шагами
+        std::vector<PaddedDouble> slots(num_threads, PaddedDouble{ 0.0 });
+        #pragma omp parallel
+        {
+            const int tid = omp_get_thread_num();
+            const int nt = omp_get_num_threads();
+            double local = 0.0;
+            #pragma omp for schedule(static)
+            for (size_t i = 0; i < a.size(); ++i) {
+                local += a[i];
+            }
+            slots[tid].value = local;
+            #pragma omp barrier
+            for (int step = 1; step < nt; step *= 2) {
+                if (tid % (2 * step) == 0 && tid + step < nt) {
+                    slots[tid].value += slots[tid + step].value;
+                }
+                #pragma omp barrier
+            }
+        }
+        sum = slots[0].value;
+    }
+    else if (method == "local_atomic") {
+        // Локальная сумма в регистре и одна атомарная запись на поток
+        #pragma omp parallel
+        {
+            double local = 0.0;
+            #pragma omp for schedule(static) nowait
+            for (size_t i = 0; i < a.size(); ++i) {
+                local += a[i];
+            }
+            #pragma omp atomic
+            sum += local;
+        }
+    }
+    else if (method == "deterministic") {
+        // Фиксированные блоки и фиксированное дерево: побитово одинаково при любом числе потоков
+        sum = deterministic_sum(a.data(), a.size(), num_threads);
+    }
+    return sum;
 }
 
 int main() {
@@ -62,7 +121,7 @@ int main() {
 
     std::vector<int> thread_counts = { 1, 2, 4, 6, 8, 12 };
     std::vector<size_t> sizes = { 500000, 1000000, 5000000, 10000000 };
-    std::vector<std::string> methods = { "reduction", "atomic", "critical", "lock" };
+    std::vector<std::string> methods = { "reduction", "atomic", "critical", "lock", "padded", "tree", "local_atomic", "deterministic" };
 
     std::cout << "Тестируемые количества потоков: ";
     for (int t : thread_counts) std::cout << t << " ";
@@ -77,18 +136,7 @@ int main() {
     std::cout << std::endl;
 
     std::string results_dir = "./Results";
-    
-    std::cout << "Проверяем наличие директории Results" << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << "Создаем директорию Results" << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cerr << "Ошибка: Не удалось создать директорию Results" << std::endl;
-            return 1;
-        }
-        std::cout << "Директория Results создана успешно" << std::endl;
-    } else {
-        std::cout << "Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
     std::string log_path = results_dir + "/7_log.txt";
     std::ofstream log_file(log_path);
@@ -100,10 +148,16 @@ int main() {
     
     std::cout << "Файл для записи результатов открыт: " << log_path << std::endl;
 
-    const int num_tests = 3;
+    ResultWriter results("7", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
     double base_time = 0.0;
+    // Время каждого метода на самом большом векторе и максимуме потоков — для сравнения с reduction
+    std::map<std::string, double> largest_times;
 
     log_file << "OpenMP Reduction Methods Testing\n";
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
     log_file << "Threads tested: ";
     for (int t : thread_counts) log_file << t << " ";
     log_file << "\nVector sizes: ";
@@ -122,21 +176,35 @@ int main() {
             a[i] = dist(gen);
         std::cout << "Данные сгенерированы" << std::endl;
 
+        // Все методы складывают одно и то же в разном порядке — сверяем с точностью до округления
+        const double reference = test_reduction_method(a, thread_counts.back(), "reduction");
+        for (const auto& method : methods) {
+            const double result = test_reduction_method(a, thread_counts.back(), method);
+            if (std::fabs(result - reference) > 1e-9 * std::fabs(reference)) {
+                std::cerr << "Ошибка: метод " << method << " дал " << result << " вместо " << reference << std::endl;
+                return 1;
+            }
+        }
+        const double deterministic = test_reduction_method(a, 1, "deterministic");
+        for (int threads : thread_counts) {
+            if (test_reduction_method(a, threads, "deterministic") != deterministic) {
+                std::cerr << "Ошибка: deterministic на " << threads << " потоках не совпал побитово с 1 потоком" << std::endl;
+                return 1;
+            }
+        }
+
         for (const auto& method : methods) {
             std::cout << "Тестируем метод: " << method << std::endl;
             
             log_file << "Vector size: " << size << "\n";
             log_file << "Method: " << method << "\n";
+            const std::string params = "size=" + std::to_string(size);
+            results.set_elements(static_cast<double>(size));
 
             std::cout << "Базовый замер (1 поток)" << std::endl;
-            double total_time = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                auto start = std::chrono::high_resolution_clock::now();
-                test_reduction_method(a, 1, method);
-                auto end = std::chrono::high_resolution_clock::now();
-                total_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            base_time = total_time / num_tests;
+            base_time = results.measure(method, params, 1, [&] {
+                do_not_optimize(test_reduction_method(a, 1, method));
+            }, bench).median;
             log_file << "Threads: 1\n";
             log_file << " Time: " << base_time << " ms (speedup: 1.0x, efficiency: 1.0)\n";
             
@@ -148,18 +216,14 @@ int main() {
                 
                 std::cout << "Тестируем " << threads << " потоков" << std::endl;
                 
-                total_time = 0.0;
-                for (int t = 0; t < num_tests; ++t) {
-                    auto start = std::chrono::high_resolution_clock::now();
-                    test_reduction_method(a, threads, method);
-                    auto end = std::chrono::high_resolution_clock::now();
-                    total_time += std::chrono::duration<double, std::milli>(end - start).count();
-                }
-                double avg_time = total_time / num_tests;
+                double avg_time = results.measure(method, params, threads, [&] {
+                    do_not_optimize(test_reduction_method(a, threads, method));
+                }, bench).median;
                 double speedup = base_time / avg_time;
                 double efficiency = speedup / threads;
                 log_file << "Threads: " << threads << "\n";
                 log_file << " Time: " << avg_time << " ms (speedup: " << speedup << "x, efficiency: " << efficiency << ")\n";
+                if (size == sizes.back() && threads == thread_counts.back()) largest_times[method] = avg_time;
                 
                 std::cout << threads << " потоков: " << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
             }
@@ -169,6 +233,15 @@ int main() {
         std::cout << "Вектор размером " << size << " полностью обработан" << std::endl;
     }
 
+    log_file << "Versus reduction at " << sizes.back() << " elements, " << thread_counts.back() << " threads:";
+    std::cout << "Сравнение с reduction (" << sizes.back() << " элементов, " << thread_counts.back() << " потоков):" << std::endl;
+    for (const auto& method : methods) {
+        const double ratio = largest_times[method] / largest_times["reduction"];
+        log_file << " " << method << " " << ratio << "x";
+        std::cout << "  " << method << ": " << largest_times[method] << " мс, " << ratio << "x от reduction" << std::endl;
+    }
+    log_file << "\n";
+
     log_file.close();
     
     std::cout << "Результаты сохранены в файл: " << log_path << std::endl;
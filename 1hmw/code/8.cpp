@@ -5,113 +5,739 @@
 #include <fstream>
 #include <string>
 #include <atomic>
-#include <thread>
-#include <mutex>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
 #include <sys/stat.h>
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+#include "bench.h"
+#include "results.h"
+#include "deterministic_sum.h"
+#include "pipeline.h"
+#include "spsc_ring.h"
+#include "vector_file.h"
+
+inline double pair_dot(const double* x, const double* y, int D) {
+    double sum = 0.0;
+    for (int k = 0; k < D; ++k) {
+        sum += x[k] * y[k];
+    }
+    return sum;
+}
+
+// Откуда производитель берёт числа текстового файла: iostream по одному числу, весь
+// файл через mmap с разбором std::from_chars прямо в память вектора, или то же самое
+// всеми потоками по кускам до запуска конвейера. Бинарный набор распознаётся по
+// сигнатуре и читается без разбора независимо от этого выбора
+enum class VectorParser { Stream, Mapped, Parallel };
+
+inline const char* parser_name(VectorParser parser) {
+    switch (parser) {
+    case VectorParser::Mapped: return "mmap+from_chars";
+    case VectorParser::Parallel: return "parallel mmap+from_chars";
+    default: return "ifstream";
+    }
+}
+
+// Читатели векторов: open проверяет файл и отдаёт заголовок, read возвращает указатель
+// на следующий вектор (nullptr при ошибке). Текстовые читатели разбирают числа в scratch,
+// бинарный отдаёт указатель прямо в отображение и scratch не трогает (kZeroCopy)
+class StreamVectorReader {
+public:
+    static const bool kZeroCopy = false;
+
+    bool open(const std::string& filename, int& total_vectors, int& vector_dim) {
+        ifs_.open(filename);
+        if (!ifs_.is_open()) {
+            std::cerr << "Ошибка: не удалось открыть файл " << filename << std::endl;
+            return false;
+        }
+        return static_cast<bool>(ifs_ >> total_vectors >> vector_dim);
+    }
+
+    const double* read(double* scratch, int D) {
+        for (int j = 0; j < D; ++j) {
+            ifs_ >> scratch[j];
+        }
+        return ifs_ ? scratch : nullptr;
+    }
+
+private:
+    std::ifstream ifs_;
+};
+
+class MappedVectorReader {
+public:
+    static const bool kZeroCopy = false;
+
+    MappedVectorReader() : cursor_(nullptr, nullptr) {}
+
+    bool open(const std::string& filename, int& total_vectors, int& vector_dim) {
+        if (!file_.open(filename)) return false;
+        cursor_ = TextCursor(file_.data(), file_.data() + file_.size());
+        return read_vector_header(cursor_, total_vectors, vector_dim);
+    }
+
+    const double* read(double* scratch, int D) { return parse_vectors(cursor_, 1, D, scratch) ? scratch : nullptr; }
+
+private:
+    MappedFile file_;
+    TextCursor cursor_;
+};
+
+class BinaryVectorReader {
+public:
+    static const bool kZeroCopy = true;
+
+    BinaryVectorReader() : next_(0) {}
+
+    bool open(const std::string& filename, int& total_vectors, int& vector_dim) {
+        if (!set_.open(filename)) return false;
+        next_ = 0;
+        total_vectors = static_cast<int>(set_.count());
+        vector_dim = static_cast<int>(set_.dim());
+        return true;
+    }
+
+    const double* read(double*, int) { return next_ < set_.count() ? set_.row(next_++) : nullptr; }
+
+private:
+    MappedVectorSet set_;
+    size_t next_;
+};
+
+// Текст, заранее разобранный всеми потоками (parse_numbers_parallel). load вызывается вне
+// parallel sections, чтобы получить полную команду потоков, а не вложенную из одного;
+// если заголовок не подходит под N и D, разбор пропускается, а сообщение об ошибке
+// выдаст produce_vectors по заголовку, как и для остальных читателей
+class ParallelVectorReader {
+public:
+    static const bool kZeroCopy = true;
+
+    ParallelVectorReader() : loaded_(false), total_vectors_(0), vector_dim_(0), next_(0) {}
+
+    bool load(const std::string& filename, int N, int D, int num_threads) {
+        loaded_ = false;
+        next_ = 0;
+        MappedFile file;
+        if (!file.open(filename)) return false;
+        TextCursor cursor(file.data(), file.data() + file.size());
+        if (!read_vector_header(cursor, total_vectors_, vector_dim_)) return false;
+        loaded_ = true;
+        if (vector_dim_ != D || total_vectors_ < N) return true;
+
+        values_.resize(static_cast<size_t>(N) * D);
+        if (!parse_numbers_parallel(cursor.position(), file.data() + file.size(), values_.size(), num_threads,
+                                    values_.data())) {
+            std::cerr << "Ошибка: не удалось разобрать " << N << " векторов в файле " << filename << std::endl;
+            loaded_ = false;
+        }
+        return loaded_;
+    }
+
+    bool open(const std::string&, int& total_vectors, int& vector_dim) {
+        total_vectors = total_vectors_;
+        vector_dim = vector_dim_;
+        return loaded_;
+    }
+
+    const double* read(double*, int D) {
+        const size_t offset = next_ * static_cast<size_t>(D);
+        if (offset + D > values_.size()) return nullptr;
+        ++next_;
+        return values_.data() + offset;
+    }
+
+    const std::vector<double>& values() const { return values_; }
+
+private:
+    bool loaded_;
+    int total_vectors_;
+    int vector_dim_;
+    size_t next_;
+    std::vector<double> values_;
+};
+
+// Заголовок файла любого формата (для проверок до запуска)
+bool peek_vector_header(const std::string& filename, int& total_vectors, int& vector_dim) {
+    if (is_vector_set_file(filename)) {
+        BinaryVectorReader reader;
+        return reader.open(filename, total_vectors, vector_dim);
+    }
+    std::ifstream in(filename);
+    return static_cast<bool>(in >> total_vectors >> vector_dim);
+}
+
+// Подходит ли прочитанный заголовок под N векторов размерности D (с сообщением, если нет)
+bool check_vector_header(bool opened, const std::string& filename, int total_vectors, int vector_dim, int N, int D) {
+    if (!opened) {
+        std::cerr << "Ошибка: не удалось прочитать заголовок файла " << filename << std::endl;
+        return false;
+    }
+    if (vector_dim != D) {
+        std::cerr << "Ошибка: размерность векторов в файле (" << vector_dim
+                  << ") не соответствует ожидаемой (" << D << ")" << std::endl;
+        return false;
+    }
+    if (total_vectors < N) {
+        std::cerr << "Ошибка: в файле только " << total_vectors
+                  << " векторов, а требуется " << N << std::endl;
+        return false;
+    }
+    return true;
 }
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+// Производитель: проверяет заголовок и передаёт N векторов через кольцо. Текст разбирается
+// прямо в слот кольца, бинарный набор публикуется указателями в отображение без копий
+template <typename Reader>
+void produce_vectors(Reader& reader, const std::string& filename, int N, int D, VectorRing& ring,
+                     std::atomic<bool>& file_error) {
+    int total_vectors = 0;
+    int vector_dim = 0;
+    const bool opened = reader.open(filename, total_vectors, vector_dim);
+    if (!check_vector_header(opened, filename, total_vectors, vector_dim, N, D)) {
+        file_error = true;
+    } else {
+        for (int i = 0; i < N; ++i) {
+            const double* vec = reader.read(ring.slot_for_write(), D);
+            if (vec == nullptr) {
+                std::cerr << "Ошибка: не удалось разобрать вектор " << i << " в файле " << filename << std::endl;
+                file_error = true;
+                break;
+            }
+            ring.publish(vec);
+        }
+    }
+    ring.close();
 }
 
-void test_sections(int N, int D, const std::string& filename, int num_threads) {
+// Один поток: чтение и счёт по очереди в одном цикле, без кольца и без секций.
+// Текстовому читателю нужны два буфера — текущий вектор и предыдущий, которые
+// чередуются; бинарный и заранее разобранный отдают указатели в свою память
+template <typename Reader>
+double consume_inline(Reader& reader, const std::string& filename, int N, int D, double* pair_dots,
+                      std::atomic<bool>& file_error) {
+    int total_vectors = 0;
+    int vector_dim = 0;
+    const bool opened = reader.open(filename, total_vectors, vector_dim);
+    if (!check_vector_header(opened, filename, total_vectors, vector_dim, N, D)) {
+        file_error = true;
+        return 0.0;
+    }
+    std::vector<double> scratch(Reader::kZeroCopy ? 0 : 2 * static_cast<size_t>(D));
+    double scal = 0.0;
+    const double* prev = nullptr;
+    for (int i = 0; i < N; ++i) {
+        double* buffer = Reader::kZeroCopy ? nullptr : scratch.data() + (i % 2) * static_cast<size_t>(D);
+        const double* vec = reader.read(buffer, D);
+        if (vec == nullptr) {
+            std::cerr << "Ошибка: не удалось разобрать вектор " << i << " в файле " << filename << std::endl;
+            file_error = true;
+            return 0.0;
+        }
+        if (prev != nullptr) {
+            const double sum = pair_dot(prev, vec, D);
+            if (pair_dots != nullptr) pair_dots[i - 1] = sum;
+            else scal += sum;
+        }
+        prev = vec;
+    }
+    return scal;
+}
+
+// Слотов в кольце между производителем и потребителем
+const size_t kRingSlots = 256;
+
+// Сумма скалярных произведений соседних векторов файла. При deterministic = true
+// произведение каждой пары пишется по её номеру, а складываются они после чтения
+// через deterministic_sum — результат не зависит ни от числа потоков, ни от того,
+// какими порциями потребитель забирал векторы
+double test_sections(int N, int D, const std::string& filename, int num_threads, bool deterministic = false,
+                     VectorParser parser = VectorParser::Parallel) {
     omp_set_dynamic(0);
     omp_set_num_threads(num_threads);
 
-    std::vector<std::vector<double>> buffer;
-    buffer.reserve(N);
+    // Читатели живут до конца функции: бинарный отдаёт указатели в своё отображение
+    StreamVectorReader stream_reader;
+    MappedVectorReader mapped_reader;
+    BinaryVectorReader binary_reader;
+    ParallelVectorReader parallel_reader;
+    const bool binary = is_vector_set_file(filename);
+    if (!binary && parser == VectorParser::Parallel) {
+        parallel_reader.load(filename, N, D, num_threads);
+    }
 
-    std::mutex mtx;
-    std::atomic<bool> finished{false};
+    // Бинарный набор читается своим читателем независимо от parser
+    auto with_reader = [&](const auto& body) {
+        if (binary) body(binary_reader);
+        else if (parser == VectorParser::Parallel) body(parallel_reader);
+        else if (parser == VectorParser::Mapped) body(mapped_reader);
+        else body(stream_reader);
+    };
     std::atomic<bool> file_error{false};
 
     double scal = 0.0;
+    std::vector<double> pair_dots(deterministic && N > 1 ? N - 1 : 0);
+    double* const pair_out = deterministic ? pair_dots.data() : nullptr;
 
-    #pragma omp parallel sections
-    {
-        #pragma omp section
-        {
-            std::ifstream ifs(filename);
-            if (!ifs.is_open()) {
-                std::cerr << "Ошибка: не удалось открыть файл " << filename << std::endl;
-                file_error = true;
-                finished = true;
-            } else {
-                int total_vectors;
-                int vector_dim;
-                ifs >> total_vectors >> vector_dim;
-                
-                if (vector_dim != D) {
-                    std::cerr << "Ошибка: размерность векторов в файле (" << vector_dim
-                              << ") не соответствует ожидаемой (" << D << ")" << std::endl;
-                    file_error = true;
-                    finished = true;
-                } else if (total_vectors < N) {
-                    std::cerr << "Ошибка: в файле только " << total_vectors
-                              << " векторов, а требуется " << N << std::endl;
-                    file_error = true;
-                    finished = true;
-                } else {
-                    for (int i = 0; i < N; ++i) {
-                        std::vector<double> vec(D);
-                        for (int j = 0; j < D; ++j) {
-                            ifs >> vec[j];
-                        }
-                        {
-                            std::lock_guard<std::mutex> lock(mtx);
-                            buffer.push_back(std::move(vec));
-                        }
-                    }
-                    finished = true;
-                }
-            }
-        }
+    if (num_threads == 1) {
+        with_reader([&](auto& reader) { scal = consume_inline(reader, filename, N, D, pair_out, file_error); });
+    } else {
+        // Читателям без копий (kZeroCopy) слоты кольца не нужны: публикуются указатели
+        bool zero_copy = false;
+        with_reader([&](auto& reader) { zero_copy = std::decay_t<decltype(reader)>::kZeroCopy; });
+        VectorRing ring(kRingSlots, D, !zero_copy);
 
-        #pragma omp section
+        #pragma omp parallel sections
         {
-            while (!finished || !buffer.empty()) {
-                if (file_error) {
-                    break;
-                }
-                
-                std::vector<std::vector<double>> local_copy;
+            #pragma omp section
+            {
+                with_reader([&](auto& reader) { produce_vectors(reader, filename, N, D, ring, file_error); });
+            }
 
-                {
-                    std::lock_guard<std::mutex> lock(mtx);
-                    if (!buffer.empty()) {
-                        local_copy.swap(buffer);
-                    }
-                }
+            #pragma omp section
+            {
+                // Потребитель держит в кольце последний вектор порции (held = 1), поэтому
+                // пара на стыке порций тоже учитывается. first — номер вектора ring.at(0)
+                size_t held = 0;
+                int first = 0;
+                while (true) {
+                    const size_t available = ring.wait_for_more(held);
+                    if (available <= held) break;
 
-                if (!local_copy.empty()) {
                     double local_scal = 0.0;
                     #pragma omp parallel for reduction(+:local_scal)
-                    for (int i = 0; i < (int)local_copy.size() - 1; ++i) {
-                        double sum = 0.0;
-                        for (int k = 0; k < D; ++k) {
-                            sum += local_copy[i][k] * local_copy[i + 1][k];
-                        }
-                        local_scal += sum;
+                    for (int i = 0; i < (int)available - 1; ++i) {
+                        const double sum = pair_dot(ring.at(i), ring.at(i + 1), D);
+                        if (deterministic) pair_dots[first + i] = sum;
+                        else local_scal += sum;
                     }
                     scal += local_scal;
+
+                    ring.release(available - 1);
+                    first += static_cast<int>(available - 1);
+                    held = 1;
                 }
-                else if (!finished) {
-                    std::this_thread::yield();
-                }
+                ring.release(held);
             }
         }
     }
-    
+
     if (file_error) {
         std::cerr << "Функция test_sections завершена с ошибкой" << std::endl;
+        return 0.0;
+    }
+    if (deterministic) {
+        scal = deterministic_sum(pair_dots.data(), pair_dots.size(), num_threads);
+    }
+    return scal;
+}
+
+// Конвейер чтение -> разбор -> счёт на постоянном пуле потоков (pipeline.h). В отличие от
+// parallel for, вложенного в секцию (там команда из одного потока, если вложенность
+// выключена), потоки делятся между стадиями явно, а счётчики стадий показывают узкое место.
+// Стадия чтения всегда одна: она идёт по файлу последовательно
+struct PipelineConfig {
+    int parse_threads;
+    int compute_threads;
+};
+
+// Кусок файла от стадии чтения: текст [begin, end) или строки бинарного набора с begin;
+// в нём числа с номерами [first, first + count) от начала данных
+struct FileChunk {
+    const char* begin;
+    const char* end;
+    size_t first;
+    size_t count;
+};
+
+// Разобранные числа [first, first + count), уже лежащие в общем массиве значений
+struct ParsedRange {
+    size_t first;
+    size_t count;
+};
+
+const size_t kPipelineChunkBytes = 1 << 20;
+const size_t kPipelineQueueSlots = 16;
+
+// Пул создаётся один раз и пересоздаётся, только если запуску нужно больше потоков
+StagePool& stage_pool(int threads) {
+    static std::unique_ptr<StagePool> pool;
+    if (!pool || pool->size() < threads) pool.reset(new StagePool(threads));
+    return *pool;
+}
+
+// Та же сумма, что у test_sections в воспроизводимом режиме (побитово): произведение пары
+// пишется по её номеру. Пары целиком внутри куска считает стадия счёта, пары на стыке
+// кусков (их не больше двух на стык) досчитываются после конвейера
+double test_pipeline(int N, int D, const std::string& filename, const PipelineConfig& config,
+                     std::vector<StageReport>* reports = nullptr) {
+    if (config.parse_threads < 1 || config.compute_threads < 1) {
+        std::cerr << "Ошибка: каждой стадии конвейера нужен хотя бы один поток" << std::endl;
+        return 0.0;
+    }
+    const size_t total = static_cast<size_t>(N) * D;
+    const bool binary = is_vector_set_file(filename);
+    MappedFile text;
+    MappedVectorSet set;
+    const char* data_begin = nullptr;
+    const char* data_end = nullptr;
+    int total_vectors = 0;
+    int vector_dim = 0;
+    bool opened = false;
+    if (binary) {
+        opened = set.open(filename);
+        total_vectors = static_cast<int>(set.count());
+        vector_dim = static_cast<int>(set.dim());
+    } else if (text.open(filename)) {
+        TextCursor cursor(text.data(), text.data() + text.size());
+        opened = read_vector_header(cursor, total_vectors, vector_dim);
+        data_begin = cursor.position();
+        data_end = text.data() + text.size();
+    }
+    if (!check_vector_header(opened, filename, total_vectors, vector_dim, N, D)) {
+        std::cerr << "Функция test_pipeline завершена с ошибкой" << std::endl;
+        return 0.0;
+    }
+
+    std::vector<double> values(total);
+    std::vector<double> pair_dots(N > 1 ? N - 1 : 0);
+    std::vector<size_t> chunk_starts;
+    std::atomic<bool> file_error{false};
+    BoundedQueue<FileChunk> parse_queue(kPipelineQueueSlots);
+    BoundedQueue<ParsedRange> compute_queue(kPipelineQueueSlots);
+
+    // Чтение: режет файл на куски по строкам (или по целым векторам) и нумерует числа;
+    // count_numbers проходит по всему куску, так что страницы файла подгружает эта стадия
+    auto read_stage = [&](int, StageCounters& counters) {
+        size_t next = 0;
+        if (binary) {
+            const size_t row_bytes = set.stride() * sizeof(double);
+            const size_t rows_per_chunk = std::max<size_t>(1, kPipelineChunkBytes / row_bytes);
+            for (size_t row = 0; row < static_cast<size_t>(N); row += rows_per_chunk) {
+                const auto start = std::chrono::steady_clock::now();
+                const size_t rows = std::min(rows_per_chunk, static_cast<size_t>(N) - row);
+                const FileChunk chunk = { reinterpret_cast<const char*>(set.row(row)),
+                                          reinterpret_cast<const char*>(set.row(row + rows)), row * D, rows * D };
+                chunk_starts.push_back(chunk.first);
+                next += chunk.count;
+                counters.busy_ns += elapsed_ns(start);
+                ++counters.items;
+                parse_queue.push(chunk, counters);
+            }
+            return;
+        }
+        const char* pos = data_begin;
+        while (next < total && pos < data_end) {
+            const auto start = std::chrono::steady_clock::now();
+            const char* stop = pos + std::min<size_t>(kPipelineChunkBytes, data_end - pos);
+            while (stop < data_end && stop[-1] != '\n') ++stop;
+            const FileChunk chunk = { pos, stop, next, std::min(count_numbers(pos, stop), total - next) };
+            pos = stop;
+            next += chunk.count;
+            counters.busy_ns += elapsed_ns(start);
+            if (chunk.count == 0) continue;
+            chunk_starts.push_back(chunk.first);
+            ++counters.items;
+            parse_queue.push(chunk, counters);
+        }
+        if (next < total) {
+            std::cerr << "Ошибка: в файле " << filename << " меньше " << N << " векторов" << std::endl;
+            file_error = true;
+        }
+    };
+
+    // Разбор: текст через TextCursor, строки бинарного набора копируются без выравнивания
+    auto parse_stage = [&](int, StageCounters& counters) {
+        FileChunk chunk;
+        while (parse_queue.pop(chunk, counters)) {
+            const auto start = std::chrono::steady_clock::now();
+            bool ok = true;
+            if (binary) {
+                const double* row = reinterpret_cast<const double*>(chunk.begin);
+                for (size_t i = 0; i < chunk.count; i += D, row += set.stride()) {
+                    std::memcpy(values.data() + chunk.first + i, row, D * sizeof(double));
+                }
+            } else {
+                TextCursor cursor(chunk.begin, chunk.end);
+                for (size_t i = 0; i < chunk.count && ok; ++i) {
+                    ok = cursor.next(values[chunk.first + i]);
+                }
+            }
+            counters.busy_ns += elapsed_ns(start);
+            ++counters.items;
+            if (!ok) {
+                std::cerr << "Ошибка: не удалось разобрать числа с номера " << chunk.first
+                          << " в файле " << filename << std::endl;
+                file_error = true;
+                continue;
+            }
+            compute_queue.push(ParsedRange{ chunk.first, chunk.count }, counters);
+        }
+    };
+
+    auto compute_stage = [&](int, StageCounters& counters) {
+        ParsedRange range;
+        while (compute_queue.pop(range, counters)) {
+            const auto start = std::chrono::steady_clock::now();
+            const size_t end = range.first + range.count;
+            for (size_t p = (range.first + D - 1) / D; (p + 2) * D <= end; ++p) {
+                pair_dots[p] = pair_dot(values.data() + p * D, values.data() + (p + 1) * D, D);
+            }
+            counters.busy_ns += elapsed_ns(start);
+            ++counters.items;
+        }
+    };
+
+    const std::vector<StageSpec> stages = {
+        { "read", 1, read_stage, [&] { parse_queue.close(); } },
+        { "parse", config.parse_threads, parse_stage, [&] { compute_queue.close(); } },
+        { "compute", config.compute_threads, compute_stage, nullptr },
+    };
+    const std::vector<StageReport> stage_reports =
+        stage_pool(1 + config.parse_threads + config.compute_threads).run(stages);
+    if (reports != nullptr) *reports = stage_reports;
+
+    if (file_error) {
+        std::cerr << "Функция test_pipeline завершена с ошибкой" << std::endl;
+        return 0.0;
+    }
+
+    // Пары p, у которых p * D < s < (p + 2) * D для начала куска s
+    std::vector<size_t> seam_pairs;
+    for (size_t s : chunk_starts) {
+        if (s == 0) continue;
+        const size_t last = (s - 1) / D;
+        for (size_t p = (last > 0 ? last - 1 : 0); p <= last; ++p) {
+            if ((p + 2) * D > s && p + 1 < static_cast<size_t>(N)) seam_pairs.push_back(p);
+        }
+    }
+    std::sort(seam_pairs.begin(), seam_pairs.end());
+    seam_pairs.erase(std::unique(seam_pairs.begin(), seam_pairs.end()), seam_pairs.end());
+    for (size_t p : seam_pairs) {
+        pair_dots[p] = pair_dot(values.data() + p * D, values.data() + (p + 1) * D, D);
+    }
+    return deterministic_sum(pair_dots.data(), pair_dots.size(), config.compute_threads);
+}
+
+// Строки по стадиям: загрузка и доли ожидания, а в конце — самая загруженная стадия.
+// Узкое место почти всё время работает, а стадии после него ждут входа
+void log_pipeline_stages(std::ofstream& log_file, const std::vector<StageReport>& reports) {
+    const StageReport* bottleneck = nullptr;
+    for (const StageReport& r : reports) {
+        log_file << "  " << r.name << " x" << r.threads << ": busy " << 100.0 * r.utilization()
+                 << "%, waiting for input " << 100.0 * r.share(r.totals.wait_in_ns)
+                 << "%, blocked on output " << 100.0 * r.share(r.totals.wait_out_ns) << "%, "
+                 << r.totals.items << " chunks\n";
+        if (bottleneck == nullptr || r.utilization() > bottleneck->utilization()) bottleneck = &r;
+    }
+    if (bottleneck != nullptr) {
+        log_file << "  Bottleneck: " << bottleneck->name << " (busy " << 100.0 * bottleneck->utilization() << "%)\n";
+    }
+}
+
+// Случайные векторы в том же текстовом формате, что и исходные файлы
+bool generate_vector_file(const std::string& path, int N, int D, unsigned seed) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Ошибка: не удалось создать файл " << path << std::endl;
+        return false;
+    }
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(-100.0, 100.0);
+    out << N << " " << D << "\n";
+    std::string line;
+    char number[32];
+    for (int i = 0; i < N; ++i) {
+        line.clear();
+        for (int j = 0; j < D; ++j) {
+            const int len = std::snprintf(number, sizeof(number), j + 1 < D ? "%.8f " : "%.8f\n", dist(rng));
+            line.append(number, len);
+        }
+        out << line;
+    }
+    return static_cast<bool>(out);
+}
+
+// Загрузка всего файла в out (N * D чисел подряд), без конвейера; для бинарного набора
+// это чтение отображения со скоростью страничного кэша плюс копия в out
+template <typename Reader>
+bool load_all(const std::string& filename, int N, int D, std::vector<double>& out) {
+    Reader reader;
+    int total_vectors = 0;
+    int vector_dim = 0;
+    if (!reader.open(filename, total_vectors, vector_dim) || vector_dim != D || total_vectors < N) return false;
+    out.assign(static_cast<size_t>(N) * D, 0.0);
+    for (int i = 0; i < N; ++i) {
+        double* dst = out.data() + static_cast<size_t>(i) * D;
+        const double* vec = reader.read(dst, D);
+        if (vec == nullptr) return false;
+        if (vec != dst) std::memcpy(dst, vec, D * sizeof(double));
+    }
+    return true;
+}
+
+// ./8 --parse: ifstream против mmap+from_chars на исходных и на больших сгенерированных файлах,
+// а также загрузка того же содержимого из бинарного набора (файл .bin создаётся конвертером)
+int run_parse_benchmark(std::ofstream& log_file, const std::vector<int>& thread_counts, const BenchOptions& bench,
+                        ResultWriter& results) {
+    const std::vector<std::pair<int, int>> files = { {500, 100}, {1000, 50}, {20000, 500}, {100000, 200} };
+    log_file << "Vector file parsing: " << parser_name(VectorParser::Stream) << " vs "
+             << parser_name(VectorParser::Mapped) << " vs binary mmap\n";
+    for (const auto& p : files) {
+        const int N = p.first;
+        const int D = p.second;
+        const std::string filename = "vectors_" + std::to_string(N) + "_" + std::to_string(D) + ".txt";
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0) {
+            std::cout << "Генерируем " << filename << "..." << std::endl;
+            if (!generate_vector_file(filename, N, D, 42) || stat(filename.c_str(), &st) != 0) return 1;
+        }
+        const double mb = st.st_size / 1048576.0;
+        const std::string params = "n=" + std::to_string(N) + " d=" + std::to_string(D);
+        results.set_elements(static_cast<double>(N) * D);
+        const std::string binary_name = filename.substr(0, filename.size() - 4) + ".bin";
+        const auto convert_start = std::chrono::high_resolution_clock::now();
+        if (!convert_text_to_vector_set(filename, binary_name)) return 1;
+        const auto convert_end = std::chrono::high_resolution_clock::now();
+        const double convert_ms = std::chrono::duration<double, std::milli>(convert_end - convert_start).count();
+
+        std::vector<double> stream_values, mapped_values, binary_values;
+        bool loaded = true;
+        const double stream_ms = results.measure("parse_stream", params, 1, [&] {
+            loaded = load_all<StreamVectorReader>(filename, N, D, stream_values) && loaded;
+        }, bench).median;
+        const double mapped_ms = results.measure("parse_mmap", params, 1, [&] {
+            loaded = load_all<MappedVectorReader>(filename, N, D, mapped_values) && loaded;
+        }, bench).median;
+        const double binary_ms = results.measure("load_binary", params, 1, [&] {
+            loaded = load_all<BinaryVectorReader>(binary_name, N, D, binary_values) && loaded;
+        }, bench).median;
+        if (!loaded) {
+            std::cerr << "Ошибка: не удалось разобрать " << filename << std::endl;
+            return 1;
+        }
+        if (stream_values != mapped_values || stream_values != binary_values) {
+            std::cerr << "Ошибка: разборщики дали разные числа для " << filename << std::endl;
+            return 1;
+        }
+        log_file << "File: " << filename << ", " << st.st_size << " bytes\n";
+        log_file << "  " << parser_name(VectorParser::Stream) << ": " << stream_ms << " ms ("
+                 << mb / (stream_ms / 1000.0) << " MB/s)\n";
+        log_file << "  " << parser_name(VectorParser::Mapped) << ": " << mapped_ms << " ms ("
+                 << mb / (mapped_ms / 1000.0) << " MB/s, " << stream_ms / mapped_ms << "x faster)\n";
+        log_file << "  binary mmap: " << binary_ms << " ms (" << stream_ms / binary_ms << "x faster, "
+                 << "one-time conversion " << convert_ms << " ms)\n";
+        std::cout << filename << ": " << stream_ms << " мс -> " << mapped_ms << " мс ("
+                  << stream_ms / mapped_ms << "x)" << std::endl;
+
+        for (int threads : thread_counts) {
+            // Время включает отображение файла и проверку заголовка
+            ParallelVectorReader reader;
+            bool parallel_loaded = true;
+            const double parallel_ms = results.measure("parse_parallel", params, threads, [&] {
+                parallel_loaded = reader.load(filename, N, D, threads) && parallel_loaded;
+            }, bench).median;
+            if (!parallel_loaded || reader.values() != stream_values) {
+                std::cerr << "Ошибка: параллельный разбор " << filename << " на " << threads
+                          << " потоках дал другие числа" << std::endl;
+                return 1;
+            }
+            log_file << "  " << parser_name(VectorParser::Parallel) << " x" << threads << ": " << parallel_ms
+                     << " ms (" << mb / (parallel_ms / 1000.0) << " MB/s, " << mapped_ms / parallel_ms
+                     << "x vs serial mmap)\n";
+        }
+    }
+    return 0;
+}
+
+// Входной файл для пары размеров: бинарный набор рядом (./8 --convert), если он есть, иначе текст
+std::string input_file_name(int N, int D) {
+    const std::string base = "vectors_" + std::to_string(N) + "_" + std::to_string(D);
+    return is_vector_set_file(base + ".bin") ? base + ".bin" : base + ".txt";
+}
+
+// ./8 --pipeline [разбор счёт]: конвейер с заданным делением потоков между стадиями
+// (по умолчанию — набор делений) против воспроизводимого test_sections на одном потоке
+int run_pipeline_benchmark(std::ofstream& log_file, const std::vector<std::pair<int, int>>& size_pairs,
+                           const std::vector<PipelineConfig>& configs, const BenchOptions& bench,
+                           ResultWriter& results) {
+    log_file << "Pipeline runtime: read -> parse -> compute on a persistent thread pool\n";
+    int rc = 0;
+    for (const auto& p : size_pairs) {
+        const int N = p.first;
+        const int D = p.second;
+        const std::string filename = input_file_name(N, D);
+        int file_N = 0, file_D = 0;
+        if (!peek_vector_header(filename, file_N, file_D) || file_N < N || file_D != D) {
+            std::cerr << "Ошибка: файл " << filename << " не найден или не подходит под N=" << N
+                      << ", D=" << D << std::endl;
+            log_file << "Size: " << N << " vectors of dimension " << D << " from file " << filename << " (SKIPPED)\n";
+            log_file << "--------------------------------------\n";
+            continue;
+        }
+        log_file << "Size: " << N << " vectors of dimension " << D << " from file " << filename << "\n";
+        std::cout << "Конвейер: N=" << N << ", D=" << D << ", файл=" << filename << std::endl;
+        const double reference = test_sections(N, D, filename, 1, true);
+        results.set_elements(static_cast<double>(N) * D);
+
+        for (const PipelineConfig& config : configs) {
+            std::vector<StageReport> reports;
+            bool identical = true;
+            const std::string params = "n=" + std::to_string(N) + " d=" + std::to_string(D) + " file=" + filename +
+                                       " parse=" + std::to_string(config.parse_threads) +
+                                       " compute=" + std::to_string(config.compute_threads);
+            const int threads = 1 + config.parse_threads + config.compute_threads;
+            const double avg_time = results.measure("pipeline", params, threads, [&] {
+                if (test_pipeline(N, D, filename, config, &reports) != reference) identical = false;
+            }, bench).median;
+            log_file << "Stages: read 1, parse " << config.parse_threads << ", compute " << config.compute_threads
+                     << ": " << avg_time << " ms"
+                     << (identical ? " (matches sections result)" : " (DIFFERS from sections result)") << "\n";
+            log_pipeline_stages(log_file, reports);
+            if (!identical) {
+                std::cerr << "Ошибка: конвейер дал другой результат для " << filename << std::endl;
+                rc = 1;
+            }
+            std::cout << "  разбор " << config.parse_threads << ", счёт " << config.compute_threads << ": "
+                      << avg_time << " мс" << std::endl;
+        }
+        log_file << "--------------------------------------\n";
     }
+    return rc;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    const bool parse_mode = mode == "--parse";
+    const bool pipeline_mode = mode == "--pipeline";
+
+    // Деление потоков между стадиями конвейера: ./8 --pipeline 2 10 — два потока разбора
+    // и десять счёта; без чисел перебирается набор делений
+    std::vector<PipelineConfig> pipeline_configs = { {1, 1}, {1, 2}, {2, 2}, {2, 6}, {2, 10}, {4, 8} };
+    if (pipeline_mode && argc > 2) {
+        const int parse_threads = argc > 3 ? std::atoi(argv[2]) : 0;
+        const int compute_threads = argc > 3 ? std::atoi(argv[3]) : 0;
+        if (parse_threads < 1 || compute_threads < 1) {
+            std::cerr << "Использование: " << argv[0] << " --pipeline [<потоков разбора> <потоков счёта>]" << std::endl;
+            return 1;
+        }
+        pipeline_configs = { {parse_threads, compute_threads} };
+    }
+
+    // ./8 --convert vectors_N_D.txt vectors_N_D.bin — текст в бинарный набор
+    if (mode == "--convert") {
+        if (argc < 4) {
+            std::cerr << "Использование: " << argv[0] << " --convert <текстовый файл> <бинарный файл>" << std::endl;
+            return 1;
+        }
+        return convert_text_to_vector_set(argv[2], argv[3]) ? 0 : 1;
+    }
+
     std::cout << "Начинаем выполнение программы test_sections..." << std::endl;
     
     std::vector<int> thread_counts_all = {1, 2, 4, 6, 8, 12, 16};
@@ -131,19 +757,9 @@ int main() {
     };
 
     std::string results_dir = "./Results";
-    std::cout << "Проверяем наличие директории Results..." << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << "Создаем директорию Results..." << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cerr << "Ошибка: не удалось создать директорию Results!" << std::endl;
-            return 1;
-        }
-        std::cout << "Директория Results создана" << std::endl;
-    } else {
-        std::cout << "Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
-    std::string log_path = results_dir + "/8_log.txt";
+    std::string log_path = results_dir + (parse_mode ? "/8_parse_log.txt" : pipeline_mode ? "/8_pipeline_log.txt" : "/8_log.txt");
     std::ofstream log_file(log_path);
     if (!log_file.is_open()) {
         std::cerr << "Ошибка: не удалось открыть файл для записи!" << std::endl;
@@ -152,13 +768,31 @@ int main() {
     
     std::cout << "Файл для записи результатов открыт: " << log_path << std::endl;
 
-    const int num_tests = 3;
+    ResultWriter results("8", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
+
+    if (parse_mode) {
+        const int rc = run_parse_benchmark(log_file, thread_counts, bench, results);
+        std::cout << "Результаты сохранены в файл: " << log_path << std::endl;
+        return rc;
+    }
+
+    if (pipeline_mode) {
+        const int rc = run_pipeline_benchmark(log_file, size_pairs, pipeline_configs, bench, results);
+        std::cout << "Результаты сохранены в файл: " << log_path << std::endl;
+        return rc;
+    }
+
+    log_file << "Parser: " << parser_name(VectorParser::Parallel) << "\n";
 
     for (auto& p : size_pairs) {
         int N = p.first;
         int D = p.second;
-        // Используем ваши имена файлов
-        std::string filename = "vectors_" + std::to_string(N) + "_" + std::to_string(D) + ".txt";
+        // Используем ваши имена файлов; бинарный набор рядом берём без разбора текста
+        std::string filename = input_file_name(N, D);
         
         std::cout << "--------------------------------------------------" << std::endl;
         std::cout << "Тестируем: N=" << N << ", D=" << D << ", файл=" << filename << std::endl;
@@ -173,9 +807,9 @@ int main() {
         }
         
         // Проверяем заголовок файла
-        int file_N, file_D;
-        test_file >> file_N >> file_D;
         test_file.close();
+        int file_N = 0, file_D = 0;
+        peek_vector_header(filename, file_N, file_D);
         
         if (file_N < N) {
             std::cerr << "Ошибка: в файле " << filename << " заявлено " << file_N
@@ -196,41 +830,49 @@ int main() {
         }
         
         log_file << "Size: " << N << " vectors of dimension " << D << " from file " << filename << "\n";
+        const std::string params = "n=" + std::to_string(N) + " d=" + std::to_string(D) + " file=" + filename;
+        results.set_elements(static_cast<double>(N) * D);
 
         std::cout << "Выполняем базовый тест (1 поток)..." << std::endl;
-        double base_time = 0.0;
-        double total_time = 0.0;
-        for (int t = 0; t < num_tests; ++t) {
-            auto start = std::chrono::high_resolution_clock::now();
-            test_sections(N, D, filename, 1);
-            auto end = std::chrono::high_resolution_clock::now();
-            total_time += std::chrono::duration<double, std::milli>(end - start).count();
-        }
-        base_time = total_time / num_tests;
+        const double base_time = results.measure("sections", params, 1, [&] {
+            do_not_optimize(test_sections(N, D, filename, 1));
+        }, bench).median;
         log_file << "Threads: 1\n";
         log_file << " Time: " << base_time << " ms (speedup: 1.0x, efficiency: 1.0)\n";
         std::cout << "Базовый тест завершен: " << base_time << " мс" << std::endl;
 
+        // Воспроизводимый режим: время и побитовое совпадение результата для всех чисел потоков
+        const double deterministic_reference = test_sections(N, D, filename, 1, true);
+        bool deterministic_identical = true;
+        auto log_deterministic = [&](int threads) {
+            const double det_time = results.measure("sections_deterministic", params, threads, [&] {
+                if (test_sections(N, D, filename, threads, true) != deterministic_reference) deterministic_identical = false;
+            }, bench).median;
+            log_file << "  Deterministic: " << det_time << " ms\n";
+        };
+        log_deterministic(1);
+
         for (int threads : thread_counts) {
             if (threads == 1) continue;
             
             std::cout << "Тестируем с " << threads << " потоками..." << std::endl;
-            total_time = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                auto start = std::chrono::high_resolution_clock::now();
-                test_sections(N, D, filename, threads);
-                auto end = std::chrono::high_resolution_clock::now();
-                total_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            double avg_time = total_time / num_tests;
+            double avg_time = results.measure("sections", params, threads, [&] {
+                do_not_optimize(test_sections(N, D, filename, threads));
+            }, bench).median;
             double speedup = base_time / avg_time;
             double efficiency = speedup / threads;
             
             log_file << "Threads: " << threads << "\n";
             log_file << " Time: " << avg_time << " ms (speedup: " << speedup << "x, efficiency: " << efficiency << ")\n";
+            log_deterministic(threads);
             
             std::cout << "Тест с " << threads << " потоками завершен: " << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
         }
+        log_file << "Deterministic result: " << std::hexfloat << deterministic_reference << std::defaultfloat
+                 << (deterministic_identical ? " (bitwise identical for all thread counts)" : " (DIFFERS between runs)") << "\n";
+        if (!deterministic_identical) {
+            std::cerr << "Ошибка: воспроизводимый режим дал разные результаты" << std::endl;
+        }
         log_file << "--------------------------------------\n";
         std::cout << "Тестирование для N=" << N << ", D=" << D << " завершено" << std::endl;
     }
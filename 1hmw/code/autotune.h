@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "bench.h"
+
+// Схема планирования для schedule(runtime): вид и размер порции (0 — по умолчанию)
+struct ScheduleConfig {
+    omp_sched_t kind;
+    int chunk;
+};
+
+inline const char* schedule_kind_name(omp_sched_t kind) {
+    switch (kind) {
+    case omp_sched_static: return "static";
+    case omp_sched_dynamic: return "dynamic";
+    case omp_sched_guided: return "guided";
+    default: return "auto";
+    }
+}
+
+inline bool parse_schedule_kind(const std::string& name, omp_sched_t& kind) {
+    if (name == "static") kind = omp_sched_static;
+    else if (name == "dynamic") kind = omp_sched_dynamic;
+    else if (name == "guided") kind = omp_sched_guided;
+    else return false;
+    return true;
+}
+
+inline std::string describe_schedule(const ScheduleConfig& config) {
+    std::ostringstream out;
+    out << schedule_kind_name(config.kind) << ", chunk " << config.chunk;
+    return out.str();
+}
+
+inline void apply_schedule(const ScheduleConfig& config) {
+    omp_set_schedule(config.kind, config.chunk);
+}
+
+// Подбор схемы планирования по пробным запускам с сохранением в профиль на диске.
+// Ключ профиля: хост, ядро, форма входа и число потоков. Строка файла:
+//   <host> <kernel> <shape> <threads> <kind> <chunk> <time_ms>
+// kernel и shape не должны содержать пробелов
+class ScheduleTuner {
+public:
+    static const int kPilotRuns = 2;
+
+    explicit ScheduleTuner(const std::string& profile_path) : path_(profile_path), host_(host_name()) {
+        load();
+    }
+
+    // Схема из профиля, а если её там нет — лучшая из кандидатов по времени run(config)
+    // (один прогрев и минимум из kPilotRuns замеров); результат сразу дописывается в профиль
+    template <typename Run>
+    ScheduleConfig resolve(const std::string& kernel, const std::string& shape, int threads, const Run& run) {
+        const std::string key = make_key(kernel, shape, threads);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) return it->second.config;
+
+        ScheduleConfig best = { omp_sched_static, 0 };
+        double best_time = std::numeric_limits<double>::max();
+        for (const ScheduleConfig& candidate : candidates()) {
+            run(candidate);
+            double t_min = std::numeric_limits<double>::max();
+            for (int r = 0; r < kPilotRuns; ++r) {
+                const auto start = std::chrono::high_resolution_clock::now();
+                run(candidate);
+                const auto end = std::chrono::high_resolution_clock::now();
+                t_min = std::min(t_min, std::chrono::duration<double, std::milli>(end - start).count());
+            }
+            if (t_min < best_time) {
+                best_time = t_min;
+                best = candidate;
+            }
+        }
+
+        Entry entry = { kernel, shape, threads, best, best_time };
+        entries_[key] = entry;
+        if (!save()) {
+            std::cerr << " Предупреждение: не удалось сохранить профиль " << path_ << std::endl;
+        }
+        return best;
+    }
+
+    // Для dynamic и guided порция 0 — это порция 1 по умолчанию, поэтому 1 у них не повторяем;
+    // у static порция 0 — равные блоки, а 1 — циклическая раздача, это разные схемы
+    static std::vector<ScheduleConfig> candidates() {
+        std::vector<ScheduleConfig> result;
+        const omp_sched_t kinds[] = { omp_sched_static, omp_sched_dynamic, omp_sched_guided };
+        const int chunks[] = { 0, 1, 8, 64 };
+        for (omp_sched_t kind : kinds) {
+            for (int chunk : chunks) {
+                if (chunk == 1 && kind != omp_sched_static) continue;
+                result.push_back({ kind, chunk });
+            }
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        std::string kernel;
+        std::string shape;
+        int threads;
+        ScheduleConfig config;
+        double time_ms;
+    };
+
+    std::string make_key(const std::string& kernel, const std::string& shape, int threads) const {
+        return host_ + "|" + kernel + "|" + shape + "|" + std::to_string(threads);
+    }
+
+    // Записи других хостов сохраняются как есть, но не используются
+    void load() {
+        std::ifstream in(path_);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string host, kind_name;
+            Entry e;
+            if (!(fields >> host >> e.kernel >> e.shape >> e.threads >> kind_name >> e.config.chunk >> e.time_ms)) continue;
+            if (!parse_schedule_kind(kind_name, e.config.kind)) continue;
+            if (host == host_) {
+                entries_[make_key(e.kernel, e.shape, e.threads)] = e;
+            } else {
+                foreign_lines_.push_back(line);
+            }
+        }
+    }
+
+    bool save() const {
+        std::ofstream out(path_, std::ios::trunc);
+        if (!out.is_open()) return false;
+        for (const std::string& line : foreign_lines_) out << line << "\n";
+        for (const auto& kv : entries_) {
+            const Entry& e = kv.second;
+            out << host_ << " " << e.kernel << " " << e.shape << " " << e.threads << " "
+                << schedule_kind_name(e.config.kind) << " " << e.config.chunk << " " << e.time_ms << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    std::string path_;
+    std::string host_;
+    std::map<std::string, Entry> entries_;
+    std::vector<std::string> foreign_lines_;
+};
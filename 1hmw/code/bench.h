@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Общий замер времени для всех программ: прогревочные запуски, число повторов по
+// сходимости, медиана и разброс с отбрасыванием выбросов, и «сток» для результатов,
+// чтобы оптимизатор не выбросил работу, которую мы меряем
+
+// Директория для логов: создаётся, если её нет. false — создать не удалось
+inline bool ensure_directory(const std::string& path) {
+    std::cout << "Проверяем наличие директории " << path << "..." << std::endl;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR)) {
+        std::cout << "Директория " << path << " уже существует" << std::endl;
+        return true;
+    }
+    std::cout << "Создаем директорию " << path << "..." << std::endl;
+    if (mkdir(path.c_str(), 0755) != 0) {
+        std::cerr << "Ошибка: не удалось создать директорию " << path << "!" << std::endl;
+        return false;
+    }
+    std::cout << "Директория " << path << " создана" << std::endl;
+    return true;
+}
+
+inline std::string host_name() {
+    char buf[256] = { 0 };
+    if (gethostname(buf, sizeof(buf) - 1) != 0 || buf[0] == '\0') return "unknown-host";
+    std::string name(buf);
+    std::replace(name.begin(), name.end(), ' ', '_');
+    return name;
+}
+
+// Значение считается использованным: компилятор обязан его вычислить, но не обязан
+// никуда записывать. На GCC/Clang — пустая asm-вставка, читающая value из памяти
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "m"(value) : "memory");
+#else
+    const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+    (void)*p;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Все записи в память до этой точки считаются наблюдаемыми
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Повторы останавливаются после min_runs, как только полуширина 95% доверительного
+// интервала не больше target_ci от медианы, или кончился бюджет budget_ms, или max_runs
+struct BenchOptions {
+    int warmup_runs;
+    int min_runs;
+    int max_runs;
+    double target_ci;
+    double budget_ms;
+};
+
+// Настройки по умолчанию: один прогрев, не меньше min_runs замеров (бывший num_tests)
+inline BenchOptions bench_options(int min_runs) {
+    return BenchOptions{ 1, min_runs, std::max(min_runs, 30), 0.02, 1000.0 };
+}
+
+// Статистика по замерам без выбросов, в миллисекундах
+struct BenchStats {
+    double median;
+    double mean;
+    double min;
+    double max;
+    double stddev;
+    double ci95;     // полуширина 95% доверительного интервала для среднего
+    int runs;        // всего замеров
+    int outliers;    // отброшено как выбросы
+};
+
+// Квантиль 0.975 распределения Стьюдента для df степеней свободы
+inline double student_t975(int df) {
+    static const double table[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                      2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                      2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (df < 1) return 0.0;
+    return df <= 30 ? table[df - 1] : 1.96;
+}
+
+inline double median_of_sorted(const std::vector<double>& v) {
+    const size_t n = v.size();
+    if (n == 0) return 0.0;
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+// Выбросы — замеры дальше 3 MAD (в масштабе стандартного отклонения) от медианы:
+// редкие прерывания и промахи планировщика не сдвигают ни медиану, ни разброс
+inline BenchStats summarize_samples(std::vector<double> samples) {
+    BenchStats s = {};
+    s.runs = static_cast<int>(samples.size());
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    const double center = median_of_sorted(samples);
+    std::vector<double> deviations;
+    for (double x : samples) deviations.push_back(std::fabs(x - center));
+    std::sort(deviations.begin(), deviations.end());
+    const double limit = 3.0 * 1.4826 * median_of_sorted(deviations);
+
+    std::vector<double> kept;
+    for (double x : samples) {
+        if (limit == 0.0 || std::fabs(x - center) <= limit) kept.push_back(x);
+    }
+    s.outliers = s.runs - static_cast<int>(kept.size());
+
+    const size_t n = kept.size();
+    s.median = median_of_sorted(kept);
+    s.min = kept.front();
+    s.max = kept.back();
+    double sum = 0.0;
+    for (double x : kept) sum += x;
+    s.mean = sum / n;
+    if (n > 1) {
+        double sq = 0.0;
+        for (double x : kept) sq += (x - s.mean) * (x - s.mean);
+        s.stddev = std::sqrt(sq / (n - 1));
+        s.ci95 = student_t975(static_cast<int>(n) - 1) * s.stddev / std::sqrt(static_cast<double>(n));
+    }
+    return s;
+}
+
+// Замеряет fn() по options. Результат fn, если он есть, нужно передать в do_not_optimize
+// внутри fn — иначе вычисление может быть выброшено целиком
+template <typename Fn>
+BenchStats run_benchmark(const Fn& fn, const BenchOptions& options) {
+    for (int w = 0; w < options.warmup_runs; ++w) fn();
+
+    std::vector<double> samples;
+    double spent_ms = 0.0;
+    while (true) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        clobber_memory();
+        const auto end = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        samples.push_back(ms);
+        spent_ms += ms;
+
+        const int runs = static_cast<int>(samples.size());
+        if (runs < options.min_runs) continue;
+        if (runs >= options.max_runs || spent_ms >= options.budget_ms) break;
+        const BenchStats s = summarize_samples(samples);
+        if (s.ci95 <= options.target_ci * s.median) break;
+    }
+    return summarize_samples(samples);
+}
+
+// Строка для лога о том, как получены времена
+inline std::string describe_bench_options(const BenchOptions& options) {
+    return "median of " + std::to_string(options.min_runs) + ".." + std::to_string(options.max_runs) +
+           " runs after " + std::to_string(options.warmup_runs) + " warmup, outliers beyond 3 MAD rejected";
+}
@@ -0,0 +1,205 @@
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "results.h"
+
+// Сравнение двух наборов машиночитаемых результатов (Results/*_results.jsonl):
+//   ./compare_results <база> <кандидат> [--threshold 0.10] [--allow-missing]
+// База и кандидат — каталог Results (берутся все *_results.jsonl в нём) или один файл .jsonl.
+// Конфигурация — программа, ядро, параметры и число потоков. Замедление считается
+// регрессией, если медиана выросла больше чем на threshold и разница средних значима
+// по t-критерию Уэлча (95%). Порог по умолчанию 10%: у ядер короче миллисекунды
+// медиана между запусками процесса гуляет сильнее, чем разброс внутри одного запуска.
+// Конфигурация базы, которой нет в кандидате, — тоже провал (программа упала или ядро
+// пропало), если не задан --allow-missing.
+// Код возврата: 0 — регрессий и пропусков нет, 1 — есть, 2 — ошибка входа
+
+typedef std::map<std::string, ResultRecord> ResultSet;
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool load_results_file(const std::string& path, ResultSet& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Ошибка: не удалось открыть " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        ResultRecord r;
+        if (!parse_json_record(line, r)) {
+            std::cerr << "Ошибка: " << path << ":" << line_no << " — не запись результата" << std::endl;
+            return false;
+        }
+        // Повтор конфигурации (например, программа запускалась дважды в один файл) — берём последний
+        out[r.key()] = r;
+    }
+    return true;
+}
+
+// Каталог: все файлы *_results.jsonl в нём; иначе — один файл
+bool load_result_set(const std::string& path, ResultSet& out) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        std::cerr << "Ошибка: " << path << " не найден" << std::endl;
+        return false;
+    }
+    if (!(info.st_mode & S_IFDIR)) return load_results_file(path, out);
+
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        std::cerr << "Ошибка: не удалось прочитать каталог " << path << std::endl;
+        return false;
+    }
+    std::vector<std::string> files;
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (ends_with(name, "_results.jsonl")) files.push_back(path + "/" + name);
+    }
+    closedir(dir);
+    if (files.empty()) {
+        std::cerr << "Ошибка: в " << path << " нет файлов *_results.jsonl" << std::endl;
+        return false;
+    }
+    for (const std::string& f : files) {
+        if (!load_results_file(f, out)) return false;
+    }
+    return true;
+}
+
+struct Comparison {
+    double change;       // относительное изменение медианы
+    double t;            // t-статистика Уэлча (кандидат минус база), 0 — не определена
+    double df;
+    bool significant;
+};
+
+// t-критерий Уэлча по средним и разбросу замеров без выбросов. Если разброса нет ни в
+// одном наборе (или замер один), значимость определяется только порогом по медиане
+Comparison compare_stats(const BenchStats& base, const BenchStats& cand) {
+    Comparison c = { 0.0, 0.0, 0.0, false };
+    c.change = base.median > 0.0 ? cand.median / base.median - 1.0 : 0.0;
+    const int nb = base.runs - base.outliers;
+    const int nc = cand.runs - cand.outliers;
+    if (nb < 2 || nc < 2) {
+        c.significant = true;
+        return c;
+    }
+    const double vb = base.stddev * base.stddev / nb;
+    const double vc = cand.stddev * cand.stddev / nc;
+    const double se = std::sqrt(vb + vc);
+    if (se == 0.0) {
+        c.significant = cand.mean != base.mean;
+        return c;
+    }
+    c.t = (cand.mean - base.mean) / se;
+    c.df = (vb + vc) * (vb + vc) / (vb * vb / (nb - 1) + vc * vc / (nc - 1));
+    c.significant = std::fabs(c.t) > student_t975(std::max(1, static_cast<int>(c.df)));
+    return c;
+}
+
+void print_comparison(const char* label, const std::string& key, const BenchStats& base, const BenchStats& cand,
+                      const Comparison& c) {
+    std::cout << label << " " << key << ": " << base.median << " -> " << cand.median << " ms ("
+              << std::showpos << std::fixed << std::setprecision(1) << c.change * 100.0 << "%" << std::noshowpos;
+    if (c.t != 0.0) std::cout << std::setprecision(2) << ", t = " << c.t << ", df = " << c.df;
+    std::cout << ")" << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+// Наборы с разных машин или сборок сравнимы только условно — предупреждаем.
+// Проверяются все записи: каталог может смешивать файлы от разных запусков
+void warn_on_host_mismatch(const ResultSet& base, const ResultSet& cand) {
+    std::set<std::string> machines, compilers;
+    for (const ResultSet* set : { &base, &cand }) {
+        for (const auto& entry : *set) {
+            const HostInfo& h = entry.second.host;
+            machines.insert(h.host + ", " + h.arch + ", " + std::to_string(h.cpus) + " CPU");
+            compilers.insert(h.compiler);
+        }
+    }
+    auto list = [](const std::set<std::string>& values) {
+        std::string out;
+        for (const std::string& v : values) out += (out.empty() ? "" : "; ") + v;
+        return out;
+    };
+    if (machines.size() > 1) {
+        std::cout << "Внимание: записи сняты на разных машинах (" << list(machines) << ")" << std::endl;
+    }
+    if (compilers.size() > 1) {
+        std::cout << "Внимание: разные компиляторы (" << list(compilers) << ")" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    double threshold = 0.10;
+    bool allow_missing = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else if (arg == "--allow-missing") {
+            allow_missing = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2 || threshold < 0.0) {
+        std::cerr << "Использование: " << argv[0] << " <база> <кандидат> [--threshold 0.10] [--allow-missing]" << std::endl;
+        std::cerr << "  база, кандидат — каталог Results или файл *_results.jsonl" << std::endl;
+        std::cerr << "  --allow-missing — не считать провалом конфигурации, которых нет в кандидате" << std::endl;
+        return 2;
+    }
+
+    ResultSet base, cand;
+    if (!load_result_set(paths[0], base) || !load_result_set(paths[1], cand)) return 2;
+    std::cout << "База: " << paths[0] << " (" << base.size() << " конфигураций)" << std::endl;
+    std::cout << "Кандидат: " << paths[1] << " (" << cand.size() << " конфигураций)" << std::endl;
+    std::cout << "Порог: " << threshold * 100.0 << "% по медиане, значимость: t-критерий Уэлча, 95%" << std::endl;
+    warn_on_host_mismatch(base, cand);
+
+    int regressions = 0, improvements = 0, unchanged = 0, missing = 0;
+    for (const auto& entry : base) {
+        auto it = cand.find(entry.first);
+        if (it == cand.end()) {
+            std::cout << "НЕТ В КАНДИДАТЕ " << entry.first << std::endl;
+            ++missing;
+            continue;
+        }
+        const BenchStats& b = entry.second.stats;
+        const BenchStats& c = it->second.stats;
+        const Comparison cmp = compare_stats(b, c);
+        if (cmp.significant && cmp.change > threshold && cmp.t >= 0.0) {
+            print_comparison("РЕГРЕССИЯ", entry.first, b, c, cmp);
+            ++regressions;
+        } else if (cmp.significant && cmp.change < -threshold && cmp.t <= 0.0) {
+            print_comparison("УСКОРЕНИЕ", entry.first, b, c, cmp);
+            ++improvements;
+        } else {
+            ++unchanged;
+        }
+    }
+    int added = 0;
+    for (const auto& entry : cand) {
+        if (!base.count(entry.first)) ++added;
+    }
+
+    std::cout << "Итого: регрессий " << regressions << ", ускорений " << improvements << ", без изменений " << unchanged
+              << ", нет в кандидате " << missing << ", новых " << added << std::endl;
+    return regressions > 0 || (missing > 0 && !allow_missing) ? 1 : 0;
+}
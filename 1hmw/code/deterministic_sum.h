@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <omp.h>
+
+// Воспроизводимое суммирование: результат побитово одинаков при любом числе потоков.
+// Вход режется на блоки фиксированной длины kSumBlock, не зависящей от числа потоков;
+// блок суммируется последовательно в kSumLanes независимых накопителей (это даёт
+// параллелизм на уровне инструкций), затем суммы блоков складываются по фиксированному
+// попарному дереву. Потоки решают только, кто считает блок, но не порядок сложения
+const size_t kSumBlock = 4096;
+const int kSumLanes = 4;
+
+// Попарное сложение на месте: на шаге step к v[i] прибавляется v[i + step]
+inline double pairwise_sum(std::vector<double>& v) {
+    const size_t n = v.size();
+    if (n == 0) return 0.0;
+    for (size_t step = 1; step < n; step *= 2) {
+        for (size_t i = 0; i + step < n; i += 2 * step) {
+            v[i] += v[i + step];
+        }
+    }
+    return v[0];
+}
+
+// Сумма term(i) для i из [0, n)
+template <typename Term>
+double deterministic_sum(size_t n, int num_threads, const Term& term) {
+    const long long blocks = static_cast<long long>((n + kSumBlock - 1) / kSumBlock);
+    std::vector<double> partial(blocks);
+
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (long long b = 0; b < blocks; ++b) {
+        const size_t begin = static_cast<size_t>(b) * kSumBlock;
+        const size_t end = std::min(n, begin + kSumBlock);
+        double lanes[kSumLanes] = {};
+        size_t i = begin;
+        for (; i + kSumLanes <= end; i += kSumLanes) {
+            for (int l = 0; l < kSumLanes; ++l) {
+                lanes[l] += term(i + l);
+            }
+        }
+        for (; i < end; ++i) {
+            lanes[0] += term(i);
+        }
+        // Накопители складываются тем же попарным деревом, что и суммы блоков
+        for (int step = 1; step < kSumLanes; step *= 2) {
+            for (int l = 0; l + step < kSumLanes; l += 2 * step) {
+                lanes[l] += lanes[l + step];
+            }
+        }
+        partial[b] = lanes[0];
+    }
+    return pairwise_sum(partial);
+}
+
+inline double deterministic_sum(const double* values, size_t n, int num_threads) {
+    return deterministic_sum(n, num_threads, [values](size_t i) { return values[i]; });
+}
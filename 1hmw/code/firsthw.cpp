@@ -2,12 +2,28 @@
 #include <vector>
 #include <omp.h>
 #include <limits>
-#include <chrono>
 #include <fstream>
 #include <random>
-#include <sys/stat.h>
+#include <algorithm>
+#include <cstddef>
 
-void no_reduction_method(const std::vector<int>& vec, int num_threads) {
+#include "bench.h"
+#include "results.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MINMAX_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MINMAX_NEON 1
+#endif
+
+struct MinMax {
+    int min_val;
+    int max_val;
+};
+
+MinMax no_reduction_method(const std::vector<int>& vec, int num_threads) {
     omp_set_num_threads(num_threads);
     int n = static_cast<int>(vec.size());
 
@@ -22,9 +38,10 @@ void no_reduction_method(const std::vector<int>& vec, int num_threads) {
             if (vec[i] < min_val) min_val = vec[i];
         }
     }
+    return { min_val, max_val };
 }
 
-void reduction_method(const std::vector<int>& vec, int num_threads) {
+MinMax reduction_method(const std::vector<int>& vec, int num_threads) {
     omp_set_num_threads(num_threads);
     int n = static_cast<int>(vec.size());
 
@@ -36,15 +53,248 @@ void reduction_method(const std::vector<int>& vec, int num_threads) {
         if (vec[i] > max_val) max_val = vec[i];
         if (vec[i] < min_val) min_val = vec[i];
     }
+    return { min_val, max_val };
+}
+
+typedef MinMax (*MinMaxKernel)(const int* data, size_t n);
+
+MinMax minmax_scalar(const int* data, size_t n) {
+    MinMax r = { std::numeric_limits<int>::max(), std::numeric_limits<int>::min() };
+    for (size_t i = 0; i < n; ++i) {
+        r.min_val = std::min(r.min_val, data[i]);
+        r.max_val = std::max(r.max_val, data[i]);
+    }
+    return r;
+}
+
+#if defined(MINMAX_X86)
+// В SSE2 нет pminsd/pmaxsd (они появились в SSE4.1), поэтому выбираем через маску сравнения
+__attribute__((target("sse2")))
+MinMax minmax_sse2(const int* data, size_t n) {
+    __m128i vmin = _mm_set1_epi32(std::numeric_limits<int>::max());
+    __m128i vmax = _mm_set1_epi32(std::numeric_limits<int>::min());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i lt = _mm_cmplt_epi32(v, vmin);
+        const __m128i gt = _mm_cmpgt_epi32(v, vmax);
+        vmin = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vmin));
+        vmax = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vmax));
+    }
+    alignas(16) int lo[4], hi[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lo), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i*>(hi), vmax);
+    MinMax r = minmax_scalar(data + i, n - i);
+    for (int k = 0; k < 4; ++k) {
+        r.min_val = std::min(r.min_val, lo[k]);
+        r.max_val = std::max(r.max_val, hi[k]);
+    }
+    return r;
+}
+
+// Два независимых аккумулятора, чтобы не упираться в латентность vpminsd/vpmaxsd
+__attribute__((target("avx2")))
+MinMax minmax_avx2(const int* data, size_t n) {
+    __m256i vmin0 = _mm256_set1_epi32(std::numeric_limits<int>::max());
+    __m256i vmax0 = _mm256_set1_epi32(std::numeric_limits<int>::min());
+    __m256i vmin1 = vmin0;
+    __m256i vmax1 = vmax0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 8));
+        vmin0 = _mm256_min_epi32(vmin0, v0);
+        vmax0 = _mm256_max_epi32(vmax0, v0);
+        vmin1 = _mm256_min_epi32(vmin1, v1);
+        vmax1 = _mm256_max_epi32(vmax1, v1);
+    }
+    vmin0 = _mm256_min_epi32(vmin0, vmin1);
+    vmax0 = _mm256_max_epi32(vmax0, vmax1);
+    alignas(32) int lo[8], hi[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lo), vmin0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(hi), vmax0);
+    MinMax r = minmax_scalar(data + i, n - i);
+    for (int k = 0; k < 8; ++k) {
+        r.min_val = std::min(r.min_val, lo[k]);
+        r.max_val = std::max(r.max_val, hi[k]);
+    }
+    return r;
+}
+
+__attribute__((target("avx512f")))
+MinMax minmax_avx512(const int* data, size_t n) {
+    __m512i vmin0 = _mm512_set1_epi32(std::numeric_limits<int>::max());
+    __m512i vmax0 = _mm512_set1_epi32(std::numeric_limits<int>::min());
+    __m512i vmin1 = vmin0;
+    __m512i vmax1 = vmax0;
+    // Немаскированные _mm512_min/max_epi32 в GCC 12 берут неинициализированный источник
+    // (_mm512_undefined_epi32) и дают ложные -Wmaybe-uninitialized; маскированные формы
+    // с полной маской компилируются в тот же vpminsd/vpmaxsd
+    const __mmask16 all = 0xFFFF;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m512i v0 = _mm512_loadu_si512(data + i);
+        const __m512i v1 = _mm512_loadu_si512(data + i + 16);
+        vmin0 = _mm512_mask_min_epi32(vmin0, all, vmin0, v0);
+        vmax0 = _mm512_mask_max_epi32(vmax0, all, vmax0, v0);
+        vmin1 = _mm512_mask_min_epi32(vmin1, all, vmin1, v1);
+        vmax1 = _mm512_mask_max_epi32(vmax1, all, vmax1, v1);
+    }
+    // Хвост меньше 16 элементов дочитываем маскированной загрузкой
+    for (; i < n; i += 16) {
+        const size_t left = std::min<size_t>(16, n - i);
+        const __mmask16 m = static_cast<__mmask16>((1u << left) - 1u);
+        vmin0 = _mm512_mask_min_epi32(vmin0, m, vmin0, _mm512_maskz_loadu_epi32(m, data + i));
+        vmax0 = _mm512_mask_max_epi32(vmax0, m, vmax0, _mm512_maskz_loadu_epi32(m, data + i));
+    }
+    // Горизонтальная свёртка вручную, как в AVX2: _mm512_reduce_* страдают тем же
+    alignas(64) int lo[16], hi[16];
+    _mm512_store_si512(lo, _mm512_mask_min_epi32(vmin0, all, vmin0, vmin1));
+    _mm512_store_si512(hi, _mm512_mask_max_epi32(vmax0, all, vmax0, vmax1));
+    MinMax r = { lo[0], hi[0] };
+    for (int k = 1; k < 16; ++k) {
+        r.min_val = std::min(r.min_val, lo[k]);
+        r.max_val = std::max(r.max_val, hi[k]);
+    }
+    return r;
+}
+#elif defined(MINMAX_NEON)
+MinMax minmax_neon(const int* data, size_t n) {
+    int32x4_t vmin0 = vdupq_n_s32(std::numeric_limits<int>::max());
+    int32x4_t vmax0 = vdupq_n_s32(std::numeric_limits<int>::min());
+    int32x4_t vmin1 = vmin0;
+    int32x4_t vmax1 = vmax0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const int32x4_t v0 = vld1q_s32(data + i);
+        const int32x4_t v1 = vld1q_s32(data + i + 4);
+        vmin0 = vminq_s32(vmin0, v0);
+        vmax0 = vmaxq_s32(vmax0, v0);
+        vmin1 = vminq_s32(vmin1, v1);
+        vmax1 = vmaxq_s32(vmax1, v1);
+    }
+    MinMax r = minmax_scalar(data + i, n - i);
+    r.min_val = std::min(r.min_val, vminvq_s32(vminq_s32(vmin0, vmin1)));
+    r.max_val = std::max(r.max_val, vmaxvq_s32(vmaxq_s32(vmax0, vmax1)));
+    return r;
+}
+#endif
+
+// Набор инструкций выбирается один раз при первом вызове по cpuid
+const char* selected_isa_name = "scalar";
+
+MinMaxKernel select_minmax_kernel() {
+    static const MinMaxKernel kernel = []() -> MinMaxKernel {
+#if defined(MINMAX_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            selected_isa_name = "avx512";
+            return minmax_avx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            selected_isa_name = "avx2";
+            return minmax_avx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            selected_isa_name = "sse2";
+            return minmax_sse2;
+        }
+#elif defined(MINMAX_NEON)
+        selected_isa_name = "neon";
+        return minmax_neon;
+#endif
+        return minmax_scalar;
+    }();
+    return kernel;
+}
+
+MinMax simd_method(const std::vector<int>& vec, int num_threads) {
+    omp_set_num_threads(num_threads);
+    const MinMaxKernel kernel = select_minmax_kernel();
+    const size_t n = vec.size();
+
+    int max_val = std::numeric_limits<int>::min();
+    int min_val = std::numeric_limits<int>::max();
+
+    // Каждый поток получает один непрерывный кусок, выровненный на 16 int (64 байта)
+    #pragma omp parallel reduction(max: max_val) reduction(min: min_val)
+    {
+        const size_t nt = static_cast<size_t>(omp_get_num_threads());
+        const size_t tid = static_cast<size_t>(omp_get_thread_num());
+        const size_t chunk = ((n + nt - 1) / nt + 15) & ~static_cast<size_t>(15);
+        const size_t begin = std::min(n, tid * chunk);
+        const size_t end = std::min(n, begin + chunk);
+        if (begin < end) {
+            const MinMax local = kernel(vec.data() + begin, end - begin);
+            min_val = local.min_val;
+            max_val = local.max_val;
+        }
+    }
+
+    return { min_val, max_val };
 }
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+struct MinMaxLoc {
+    int min_val;
+    int max_val;
+    long long argmin;
+    long long argmax;
+    long long count;
+};
+
+MinMaxLoc minmax_loc_identity() {
+    return { std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), -1, -1, 0 };
 }
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+// При равных значениях побеждает меньший индекс, поэтому результат не зависит
+// от того, в каком порядке потоки сливают свои частичные результаты
+MinMaxLoc minmax_loc_combine(const MinMaxLoc& a, const MinMaxLoc& b) {
+    MinMaxLoc r;
+    if (b.argmin >= 0 && (a.argmin < 0 || b.min_val < a.min_val || (b.min_val == a.min_val && b.argmin < a.argmin))) {
+        r.min_val = b.min_val;
+        r.argmin = b.argmin;
+    } else {
+        r.min_val = a.min_val;
+        r.argmin = a.argmin;
+    }
+    if (b.argmax >= 0 && (a.argmax < 0 || b.max_val > a.max_val || (b.max_val == a.max_val && b.argmax < a.argmax))) {
+        r.max_val = b.max_val;
+        r.argmax = b.argmax;
+    } else {
+        r.max_val = a.max_val;
+        r.argmax = a.argmax;
+    }
+    r.count = a.count + b.count;
+    return r;
+}
+
+#pragma omp declare reduction(minmaxloc : MinMaxLoc : omp_out = minmax_loc_combine(omp_out, omp_in)) \
+    initializer(omp_priv = minmax_loc_identity())
+
+MinMaxLoc argminmax_method(const std::vector<int>& vec, int num_threads) {
+    omp_set_num_threads(num_threads);
+    const long long n = static_cast<long long>(vec.size());
+    const int* data = vec.data();
+
+    MinMaxLoc result = minmax_loc_identity();
+
+    // schedule(static) даёт каждому потоку возрастающий диапазон индексов,
+    // так что строгие сравнения внутри потока сохраняют первое вхождение
+    #pragma omp parallel for schedule(static) reduction(minmaxloc: result)
+    for (long long i = 0; i < n; i++) {
+        const int v = data[i];
+        if (v < result.min_val || result.argmin < 0) {
+            result.min_val = v;
+            result.argmin = i;
+        }
+        if (v > result.max_val || result.argmax < 0) {
+            result.max_val = v;
+            result.argmax = i;
+        }
+        result.count++;
+    }
+
+    return result;
 }
 
 int main() {
@@ -58,18 +308,7 @@ int main() {
     std::vector<size_t> sizes = { 100000, 500000, 1000000, 5000000 };
 
     std::string results_dir = "./Results";
-    
-    std::cout << " Проверяем наличие директории Results..." << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << " Создаем директорию Results..." << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cout << " Ошибка: Не удалось создать директорию Results!" << std::endl;
-            return 1;
-        }
-        std::cout << "Директория Results создана успешно" << std::endl;
-    } else {
-        std::cout << " Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
     std::string log_path = results_dir + "/1_log.txt";
     std::ofstream log_file(log_path);
@@ -81,13 +320,21 @@ int main() {
     
     std::cout << " Файл для записи результатов открыт: " << log_path << std::endl;
 
-   
+    ResultWriter results("1", log_path);
+    if (!results.open()) return 1;
 
-    const int num_tests = 5;
+    select_minmax_kernel();
+    std::cout << " SIMD-ядро min/max: " << selected_isa_name << std::endl;
+    log_file << "SIMD ISA: " << selected_isa_name << "\n";
+
+    const BenchOptions bench = bench_options(5);
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
 
     for (size_t size : sizes) {
         std::cout << "\n🔧 Обрабатываем вектор размером: " << size << std::endl;
         log_file << "Vector size: " << size << "\n";
+        const std::string config = "size=" + std::to_string(size);
+        results.set_elements(static_cast<double>(size));
 
         std::cout << "    Генерируем случайные данные..." << std::endl;
         std::vector<int> vec(size);
@@ -99,14 +346,9 @@ int main() {
         std::cout << "    Выполняем базовые замеры (без reduction, 1 поток)..." << std::endl;
         double base_time_no_red = 0.0;
         {
-            double time_one_thread = 0.0;
-            for (int test = 0; test < num_tests; test++) {
-                auto start = std::chrono::high_resolution_clock::now();
-                no_reduction_method(vec, 1);
-                auto end = std::chrono::high_resolution_clock::now();
-                time_one_thread += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            base_time_no_red = time_one_thread / num_tests;
+            base_time_no_red = results.measure("no_reduction", config, 1, [&] {
+                do_not_optimize(no_reduction_method(vec, 1));
+            }, bench).median;
 
             double speedup_one_no_red = (base_time_no_red > 0) ? base_time_no_red / base_time_no_red : 1.0;
             double efficiency_one_no_red = speedup_one_no_red / 1.0;
@@ -119,14 +361,9 @@ int main() {
         std::cout << "  Выполняем базовые замеры (с reduction, 1 поток)..." << std::endl;
         double base_time_red = 0.0;
         {
-            double time_one_thread_red = 0.0;
-            for (int test = 0; test < num_tests; test++) {
-                auto start = std::chrono::high_resolution_clock::now();
-                reduction_method(vec, 1);
-                auto end = std::chrono::high_resolution_clock::now();
-                time_one_thread_red += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            base_time_red = time_one_thread_red / num_tests;
+            base_time_red = results.measure("reduction", config, 1, [&] {
+                do_not_optimize(reduction_method(vec, 1));
+            }, bench).median;
 
             double speedup_one_red = (base_time_red > 0) ? base_time_red / base_time_red : 1.0;
             double efficiency_one_red = speedup_one_red / 1.0;
@@ -135,20 +372,53 @@ int main() {
         }
         std::cout << "   Базовые замеры (с reduction) завершены" << std::endl;
 
+        std::cout << "  Выполняем базовые замеры (SIMD, 1 поток)..." << std::endl;
+        double base_time_simd = 0.0;
+        {
+            const MinMax expected = minmax_scalar(vec.data(), vec.size());
+            bool simd_ok = true;
+            base_time_simd = results.measure("simd", config, 1, [&] {
+                const MinMax r = simd_method(vec, 1);
+                if (r.min_val != expected.min_val || r.max_val != expected.max_val) simd_ok = false;
+            }, bench).median;
+            if (!simd_ok) {
+                std::cerr << " Ошибка: SIMD-ядро вернуло неверный результат!" << std::endl;
+                return 1;
+            }
+
+            log_file << "  SIMD: " << base_time_simd << " ms " << "(speedup: 1x, efficiency: 1, min: "
+                     << expected.min_val << ", max: " << expected.max_val << ")\n";
+        }
+        std::cout << "   Базовые замеры (SIMD) завершены" << std::endl;
+
+        std::cout << "  Выполняем базовые замеры (argmin/argmax, 1 поток)..." << std::endl;
+        double base_time_loc = 0.0;
+        {
+            const long long expected_argmin = std::min_element(vec.begin(), vec.end()) - vec.begin();
+            const long long expected_argmax = std::max_element(vec.begin(), vec.end()) - vec.begin();
+            MinMaxLoc r = minmax_loc_identity();
+            base_time_loc = results.measure("argminmax", config, 1, [&] {
+                r = argminmax_method(vec, 1);
+            }, bench).median;
+            if (r.argmin != expected_argmin || r.argmax != expected_argmax || r.count != static_cast<long long>(size)) {
+                std::cerr << " Ошибка: argmin/argmax не совпадают с std::min_element/std::max_element!" << std::endl;
+                return 1;
+            }
+
+            log_file << "  Argminmax: " << base_time_loc << " ms " << "(speedup: 1x, efficiency: 1, argmin: "
+                     << r.argmin << ", argmax: " << r.argmax << ")\n";
+        }
+        std::cout << "   Базовые замеры (argmin/argmax) завершены" << std::endl;
+
         std::cout << "   Начинаем тестирование с разным количеством потоков..." << std::endl;
         for (int threads : thread_counts) {
             if (threads == 1) continue;
 
             std::cout << " Тестируем " << threads << " потоков..." << std::endl;
 
-            double no_reduction_time = 0.0;
-            for (int test = 0; test < num_tests; test++) {
-                auto start = std::chrono::high_resolution_clock::now();
-                no_reduction_method(vec, threads);
-                auto end = std::chrono::high_resolution_clock::now();
-                no_reduction_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            no_reduction_time /= num_tests;
+            const double no_reduction_time = results.measure("no_reduction", config, threads, [&] {
+                do_not_optimize(no_reduction_method(vec, threads));
+            }, bench).median;
             double speedup_no_red = (base_time_no_red > 0) ? base_time_no_red / no_reduction_time : 0.0;
             double efficiency_no_red = speedup_no_red / threads;
 
@@ -156,18 +426,33 @@ int main() {
             log_file << " No reduction: " << no_reduction_time << " ms " << "(speedup: " << speedup_no_red << "x, efficiency: " << efficiency_no_red << ")\n";
 
             // Тест с reduction
-            double reduction_time = 0.0;
-            for (int test = 0; test < num_tests; test++) {
-                auto start = std::chrono::high_resolution_clock::now();
-                reduction_method(vec, threads);
-                auto end = std::chrono::high_resolution_clock::now();
-                reduction_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            reduction_time /= num_tests;
+            const double reduction_time = results.measure("reduction", config, threads, [&] {
+                do_not_optimize(reduction_method(vec, threads));
+            }, bench).median;
             double speedup_red = (base_time_red > 0) ? base_time_red / reduction_time : 0.0;
             double efficiency_red = speedup_red / threads;
 
             log_file << " Reduction: " << reduction_time << " ms " << "(speedup: " << speedup_red << "x, efficiency: " << efficiency_red << ")\n";
+
+            MinMax simd_result = { 0, 0 };
+            const double simd_time = results.measure("simd", config, threads, [&] {
+                simd_result = simd_method(vec, threads);
+            }, bench).median;
+            double speedup_simd = (base_time_simd > 0) ? base_time_simd / simd_time : 0.0;
+            double efficiency_simd = speedup_simd / threads;
+
+            log_file << " SIMD: " << simd_time << " ms " << "(speedup: " << speedup_simd << "x, efficiency: " << efficiency_simd
+                     << ", min: " << simd_result.min_val << ", max: " << simd_result.max_val << ")\n";
+
+            MinMaxLoc loc_result = minmax_loc_identity();
+            const double loc_time = results.measure("argminmax", config, threads, [&] {
+                loc_result = argminmax_method(vec, threads);
+            }, bench).median;
+            double speedup_loc = (base_time_loc > 0) ? base_time_loc / loc_time : 0.0;
+            double efficiency_loc = speedup_loc / threads;
+
+            log_file << " Argminmax: " << loc_time << " ms " << "(speedup: " << speedup_loc << "x, efficiency: " << efficiency_loc
+                     << ", argmin: " << loc_result.argmin << ", argmax: " << loc_result.argmax << ")\n";
             
             std::cout <<  threads << " потоков протестированы" << std::endl;
         }
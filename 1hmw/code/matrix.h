@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+
+// Матрица int в построчном порядке: одно выделение памяти, выровненное на 64 байта,
+// шаг строки (stride) округлён вверх до 16 int, поэтому каждая строка начинается
+// с новой кэш-линии. Элементы за cols в строке — выравнивание, алгоритмы их не читают
+class Matrix {
+public:
+    static const size_t kAlignment = 64;
+    static const size_t kRowAlign = kAlignment / sizeof(int);
+
+    Matrix() : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+
+    Matrix(size_t rows, size_t cols, int fill = 0)
+        : data_(nullptr), rows_(rows), cols_(cols), stride_((cols + kRowAlign - 1) / kRowAlign * kRowAlign) {
+        const size_t bytes = rows_ * stride_ * sizeof(int);
+        if (bytes > 0) {
+            data_ = static_cast<int*>(std::aligned_alloc(kAlignment, bytes));
+            if (data_ == nullptr) throw std::bad_alloc();
+        }
+        // Первое касание страниц делают те же потоки, что потом сканируют строки
+        const long long n = static_cast<long long>(rows_);
+        #pragma omp parallel for schedule(static)
+        for (long long i = 0; i < n; ++i) {
+            std::fill(row(i), row(i) + stride_, fill);
+        }
+    }
+
+    Matrix(const Matrix&) = delete;
+    Matrix& operator=(const Matrix&) = delete;
+
+    Matrix(Matrix&& other) noexcept
+        : data_(other.data_), rows_(other.rows_), cols_(other.cols_), stride_(other.stride_) {
+        other.data_ = nullptr;
+        other.rows_ = other.cols_ = other.stride_ = 0;
+    }
+
+    Matrix& operator=(Matrix&& other) noexcept {
+        if (this != &other) {
+            std::free(data_);
+            data_ = other.data_;
+            rows_ = other.rows_;
+            cols_ = other.cols_;
+            stride_ = other.stride_;
+            other.data_ = nullptr;
+            other.rows_ = other.cols_ = other.stride_ = 0;
+        }
+        return *this;
+    }
+
+    ~Matrix() { std::free(data_); }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+
+    int* row(size_t i) { return data_ + i * stride_; }
+    const int* row(size_t i) const { return data_ + i * stride_; }
+
+    int& operator()(size_t i, size_t j) { return data_[i * stride_ + j]; }
+    int operator()(size_t i, size_t j) const { return data_[i * stride_ + j]; }
+
+private:
+    int* data_;
+    size_t rows_;
+    size_t cols_;
+    size_t stride_;
+};
+
+// Ленточная матрица n x n с полушириной k: строка i хранит столбцы [i-k, i+k] подряд,
+// всего n x (2k+1) элементов вместо n x n. Ячейки ленты за краями матрицы не используются
+class BandMatrix {
+public:
+    BandMatrix() : n_(0), k_(0) {}
+    BandMatrix(size_t n, size_t k) : band_(n, 2 * k + 1), n_(n), k_(k) {}
+
+    size_t size() const { return n_; }
+    size_t bandwidth() const { return k_; }
+    size_t bytes() const { return band_.rows() * band_.stride() * sizeof(int); }
+
+    // Хранимые столбцы строки i: [col_begin(i), col_end(i))
+    size_t col_begin(size_t i) const { return i > k_ ? i - k_ : 0; }
+    size_t col_end(size_t i) const { return std::min(n_, i + k_ + 1); }
+
+    // Указатель на элемент (i, col_begin(i)); столбец j лежит по смещению j - col_begin(i)
+    int* row(size_t i) { return band_.row(i) + (col_begin(i) + k_ - i); }
+    const int* row(size_t i) const { return band_.row(i) + (col_begin(i) + k_ - i); }
+
+private:
+    Matrix band_;
+    size_t n_;
+    size_t k_;
+};
+
+// Упакованная нижнетреугольная матрица: строки длиной 1, 2, ..., n подряд,
+// всего n(n+1)/2 элементов; строка i начинается с i(i+1)/2
+class PackedLowerMatrix {
+public:
+    PackedLowerMatrix() : n_(0) {}
+    explicit PackedLowerMatrix(size_t n) : data_(n * (n + 1) / 2), n_(n) {}
+
+    size_t size() const { return n_; }
+    size_t bytes() const { return data_.size() * sizeof(int); }
+    size_t row_length(size_t i) const { return i + 1; }
+
+    int* row(size_t i) { return data_.data() + i * (i + 1) / 2; }
+    const int* row(size_t i) const { return data_.data() + i * (i + 1) / 2; }
+
+private:
+    std::vector<int> data_;
+    size_t n_;
+};
+
+// Минимум строки без ветвлений, векторизуется под любой набор инструкций
+inline int row_min(const int* row, int cols) {
+    int min_in_row = std::numeric_limits<int>::max();
+    #pragma omp simd reduction(min:min_in_row)
+    for (int j = 0; j < cols; ++j) {
+        min_in_row = (row[j] < min_in_row) ? row[j] : min_in_row;
+    }
+    return min_in_row;
+}
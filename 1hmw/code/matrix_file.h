@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix.h"
+
+// Бинарный формат матрицы: заголовок в начале файла, данные построчно с offset.
+// offset кратен 4096, stride кратен 16 элементам, поэтому при mmap каждая строка
+// начинается с кэш-линии, а блоки строк удобно выравнивать по страницам для madvise
+const char kMatrixFileMagic[8] = { 'O', 'M', 'P', 'M', 'A', 'T', 'R', 'X' };
+const uint32_t kMatrixFileVersion = 1;
+const uint32_t kMatrixDtypeInt32 = 1;
+const uint64_t kMatrixDataOffset = 4096;
+
+struct MatrixFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t stride;
+    uint64_t data_offset;
+};
+
+inline MatrixFileHeader make_matrix_header(size_t rows, size_t cols) {
+    MatrixFileHeader h;
+    std::memcpy(h.magic, kMatrixFileMagic, sizeof(h.magic));
+    h.version = kMatrixFileVersion;
+    h.dtype = kMatrixDtypeInt32;
+    h.rows = rows;
+    h.cols = cols;
+    h.stride = (cols + Matrix::kRowAlign - 1) / Matrix::kRowAlign * Matrix::kRowAlign;
+    h.data_offset = kMatrixDataOffset;
+    return h;
+}
+
+// Заголовок согласован с размером файла. Заголовок повреждённого файла может содержать
+// любые числа, поэтому размер проверяется делением, без переполнения в произведении
+inline bool matrix_header_valid(const MatrixFileHeader& h, uint64_t file_size) {
+    if (std::memcmp(h.magic, kMatrixFileMagic, sizeof(h.magic)) != 0 || h.version != kMatrixFileVersion ||
+        h.dtype != kMatrixDtypeInt32) {
+        return false;
+    }
+    if (h.stride == 0 || h.stride < h.cols || h.stride > UINT64_MAX / sizeof(int)) return false;
+    if (h.data_offset < sizeof(MatrixFileHeader) || h.data_offset % 4096 != 0 || h.data_offset > file_size) {
+        return false;
+    }
+    return h.rows <= (file_size - h.data_offset) / (h.stride * sizeof(int));
+}
+
+// Пишет матрицу построчно, строки порождает row_fn(i, row) — так файл больше памяти
+// создаётся с буфером в одну строку
+template <typename RowFn>
+bool write_matrix_file(const std::string& path, size_t rows, size_t cols, const RowFn& row_fn) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << " Ошибка: не удалось создать файл " << path << std::endl;
+        return false;
+    }
+    const MatrixFileHeader h = make_matrix_header(rows, cols);
+    std::vector<char> header_block(h.data_offset, 0);
+    std::memcpy(header_block.data(), &h, sizeof(h));
+    out.write(header_block.data(), header_block.size());
+
+    std::vector<int> row(h.stride, 0);
+    for (size_t i = 0; i < rows; ++i) {
+        row_fn(i, row.data());
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(int));
+    }
+    if (!out) {
+        std::cerr << " Ошибка: запись в " << path << " не удалась" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+inline bool write_matrix_file(const std::string& path, const Matrix& m) {
+    return write_matrix_file(path, m.rows(), m.cols(), [&](size_t i, int* row) {
+        std::memcpy(row, m.row(i), m.cols() * sizeof(int));
+    });
+}
+
+// Матрица из файла, отображённая в память только для чтения. Страницы подгружает
+// ядро по мере обращения, так что резидентная память ограничена тем, что реально
+// сканируется, если вызывающий код отпускает пройденные блоки через advise
+class MappedMatrix {
+public:
+    MappedMatrix() : base_(nullptr), length_(0), data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+    ~MappedMatrix() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << " Ошибка: не удалось открыть " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        MatrixFileHeader h;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(h) ||
+            pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+            std::cerr << " Ошибка: не удалось прочитать заголовок " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        if (!matrix_header_valid(h, static_cast<uint64_t>(st.st_size))) {
+            std::cerr << " Ошибка: " << path << " не является файлом матрицы int32 версии "
+                      << kMatrixFileVersion << " или обрезан" << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        length_ = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << " Ошибка: mmap " << path << " не удался" << std::endl;
+            length_ = 0;
+            return false;
+        }
+        base_ = static_cast<char*>(p);
+        data_ = reinterpret_cast<const int*>(base_ + h.data_offset);
+        rows_ = h.rows;
+        cols_ = h.cols;
+        stride_ = h.stride;
+        madvise(base_, length_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (base_ != nullptr) munmap(base_, length_);
+        base_ = nullptr;
+        data_ = nullptr;
+        length_ = rows_ = cols_ = stride_ = 0;
+    }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t stride() const { return stride_; }
+    const int* row(size_t i) const { return data_ + i * stride_; }
+
+    // Совет ядру для строк [row_begin, row_end): MADV_WILLNEED — начать чтение заранее,
+    // MADV_DONTNEED — отпустить страницы (при повторном обращении они перечитаются)
+    void advise(size_t row_begin, size_t row_end, int advice) const {
+        if (base_ == nullptr || row_begin >= row_end) return;
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t begin = reinterpret_cast<const char*>(row(row_begin)) - base_;
+        const size_t end = std::min(length_, static_cast<size_t>(reinterpret_cast<const char*>(row(row_end)) - base_));
+        const size_t aligned = begin / page * page;
+        if (end > aligned) madvise(base_ + aligned, end - aligned, advice);
+    }
+
+private:
+    char* base_;
+    size_t length_;
+    const int* data_;
+    size_t rows_;
+    size_t cols_;
+    size_t stride_;
+};
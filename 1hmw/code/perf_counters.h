@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Аппаратные счётчики вокруг одного запуска ядра: циклы, инструкции, промахи LLC,
+// ошибки предсказания переходов и промахи dTLB. Счётчики открываются в каждом потоке
+// команды OpenMP для него самого (perf_event_open с pid = 0), поэтому ядро должно
+// запускать параллельную область с тем же числом потоков — libgomp переиспользует
+// те же потоки. Считается только пользовательский код (exclude_kernel), этого хватает
+// при kernel.perf_event_paranoid <= 2. Если счётчики не открылись (нет прав, не Linux,
+// виртуальная машина без PMU), CounterSample::available == false и reason объясняет почему.
+// Без OpenMP считается только вызывающий поток
+
+enum PerfEvent { kCycles, kInstructions, kLlcMisses, kBranchMisses, kDtlbMisses, kPerfEventCount };
+
+inline const char* perf_event_name(int event) {
+    static const char* names[kPerfEventCount] = { "cycles", "instructions", "LLC misses", "branch misses",
+                                                  "dTLB misses" };
+    return names[event];
+}
+
+struct CounterSample {
+    bool available = false;
+    std::string reason;                                   // почему недоступны, по-английски (для лога)
+    long long totals[kPerfEventCount] = { -1, -1, -1, -1, -1 };   // -1 — событие не открылось
+    std::vector<long long> thread_cycles;                 // циклы каждого потока команды
+
+    bool has(int event) const { return totals[event] >= 0; }
+
+    double ipc() const {
+        return has(kCycles) && has(kInstructions) && totals[kCycles] > 0
+            ? static_cast<double>(totals[kInstructions]) / totals[kCycles] : -1.0;
+    }
+
+    double per_element(int event, double elements) const {
+        return has(event) && elements > 0 ? totals[event] / elements : -1.0;
+    }
+
+    // Самый загруженный поток относительно среднего: 1 — нагрузка ровная
+    double cycle_imbalance() const {
+        if (thread_cycles.empty()) return -1.0;
+        long long sum = 0, peak = 0;
+        for (long long c : thread_cycles) {
+            if (c < 0) return -1.0;
+            sum += c;
+            if (c > peak) peak = c;
+        }
+        return sum > 0 ? peak * static_cast<double>(thread_cycles.size()) / sum : -1.0;
+    }
+};
+
+#ifdef __linux__
+
+inline int open_perf_event(int event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+    case kCycles:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case kInstructions:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case kLlcMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case kBranchMisses:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    default:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    }
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+inline std::string perf_error_reason(int err) {
+    if (err == EACCES || err == EPERM) {
+        std::string level = "?";
+        if (FILE* f = std::fopen("/proc/sys/kernel/perf_event_paranoid", "r")) {
+            int value = 0;
+            if (std::fscanf(f, "%d", &value) == 1) level = std::to_string(value);
+            std::fclose(f);
+        }
+        return "permission denied (kernel.perf_event_paranoid = " + level + ")";
+    }
+    if (err == ENOENT || err == EOPNOTSUPP) return "hardware events not supported, no PMU (e.g. in a VM)";
+    if (err == ENOSYS) return "perf_event_open not available in this kernel";
+    return std::string("perf_event_open failed: ") + std::strerror(err);
+}
+
+// Значение с поправкой на мультиплексирование (событие было на PMU не всё время)
+inline long long read_perf_event(int fd) {
+    unsigned long long buf[3] = { 0, 0, 0 };   // value, time_enabled, time_running
+    if (read(fd, buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) return -1;
+    if (buf[2] == 0) return buf[1] == 0 ? static_cast<long long>(buf[0]) : -1;
+    if (buf[2] < buf[1]) return static_cast<long long>(static_cast<double>(buf[0]) * buf[1] / buf[2]);
+    return static_cast<long long>(buf[0]);
+}
+
+// Один запуск fn() под счётчиками в каждом из threads потоков
+template <typename Fn>
+CounterSample count_events(int threads, const Fn& fn) {
+#ifndef _OPENMP
+    threads = 1;
+#endif
+    CounterSample sample;
+    std::vector<int> fds(static_cast<size_t>(threads) * kPerfEventCount, -1);
+    std::vector<int> errors(fds.size(), 0);
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(threads)
+#endif
+    {
+#ifdef _OPENMP
+        const int t = omp_get_thread_num();
+#else
+        const int t = 0;
+#endif
+        for (int e = 0; e < kPerfEventCount; ++e) {
+            const size_t slot = static_cast<size_t>(t) * kPerfEventCount + e;
+            fds[slot] = open_perf_event(e);
+            if (fds[slot] < 0) errors[slot] = errno;
+        }
+    }
+
+    // Событие учитываем, только если оно открылось во всех потоках
+    bool opened[kPerfEventCount];
+    int first_error = 0;
+    for (int e = 0; e < kPerfEventCount; ++e) {
+        opened[e] = true;
+        for (int t = 0; t < threads; ++t) {
+            const size_t slot = static_cast<size_t>(t) * kPerfEventCount + e;
+            if (fds[slot] < 0) {
+                opened[e] = false;
+                if (!first_error) first_error = errors[slot];
+            }
+        }
+        if (opened[e]) sample.available = true;
+    }
+
+    if (sample.available) {
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        fn();
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        for (int e = 0; e < kPerfEventCount; ++e) {
+            if (!opened[e]) continue;
+            long long total = 0;
+            for (int t = 0; t < threads && total >= 0; ++t) {
+                const long long v = read_perf_event(fds[static_cast<size_t>(t) * kPerfEventCount + e]);
+                total = v < 0 ? -1 : total + v;
+                if (e == kCycles) sample.thread_cycles.push_back(v);
+            }
+            sample.totals[e] = total;
+        }
+    } else {
+        sample.reason = perf_error_reason(first_error);
+    }
+
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+    return sample;
+}
+
+#else
+
+template <typename Fn>
+CounterSample count_events(int, const Fn&) {
+    CounterSample sample;
+    sample.reason = "perf_event_open is Linux-only";
+    return sample;
+}
+
+#endif
+
+// Строка для лога: IPC, промахи на элемент и дисбаланс циклов между потоками;
+// неоткрывшиеся события — n/a
+inline std::string describe_counters(const CounterSample& sample, double elements) {
+    if (!sample.available) return "unavailable (" + sample.reason + ")";
+    std::ostringstream out;
+    auto value = [&](double v) {
+        if (v < 0) out << "n/a";
+        else out << v;
+    };
+    out << "IPC ";
+    value(sample.ipc());
+    for (int e = kLlcMisses; e < kPerfEventCount; ++e) {
+        out << ", " << perf_event_name(e) << "/elem ";
+        value(sample.per_element(e, elements));
+    }
+    out << ", cycle imbalance ";
+    value(sample.cycle_imbalance());
+    return out.str();
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Счётчики одного потока стадии: сколько элементов обработано и на что ушло время
+// (работа, ожидание входа, ожидание места в выходной очереди), в наносекундах
+struct StageCounters {
+    long long items = 0;
+    long long busy_ns = 0;
+    long long wait_in_ns = 0;
+    long long wait_out_ns = 0;
+
+    void add(const StageCounters& other) {
+        items += other.items;
+        busy_ns += other.busy_ns;
+        wait_in_ns += other.wait_in_ns;
+        wait_out_ns += other.wait_out_ns;
+    }
+};
+
+inline long long elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Ограниченная блокирующая очередь между стадиями (много производителей и потребителей).
+// Элементы крупные (куски файла), поэтому мьютекс на операцию не заметен. push ждёт места
+// (противодавление), pop ждёт элемента; после close и опустошения pop возвращает false.
+// Время ожидания добавляется в счётчики вызывающего потока
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity < 1 ? 1 : capacity), closed_(false) {}
+
+    void push(T item, StageCounters& counters) {
+        const auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mtx_);
+        not_full_.wait(lock, [&] { return items_.size() < capacity_; });
+        counters.wait_out_ns += elapsed_ns(start);
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    bool pop(T& item, StageCounters& counters) {
+        const auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mtx_);
+        not_empty_.wait(lock, [&] { return !items_.empty() || closed_; });
+        counters.wait_in_ns += elapsed_ns(start);
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // Вызывается, когда все производители очереди закончили
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    bool closed_;
+    std::deque<T> items_;
+    std::mutex mtx_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// Стадия конвейера: имя, число потоков и тело body(worker, counters), которое выполняет
+// каждый из её потоков (worker — номер потока внутри стадии). Когда последний поток
+// стадии выходит из body, вызывается on_done (обычно закрывает выходную очередь)
+struct StageSpec {
+    std::string name;
+    int threads;
+    std::function<void(int, StageCounters&)> body;
+    std::function<void()> on_done;
+};
+
+struct StageReport {
+    std::string name;
+    int threads;
+    StageCounters totals;
+    double wall_ms;
+
+    // Доля времени потоков стадии (threads * wall), ушедшая на ns наносекунд
+    double share(long long ns) const { return wall_ms > 0.0 && threads > 0 ? ns / 1e6 / (wall_ms * threads) : 0.0; }
+    // Загрузка стадии: доля времени, занятая работой, а не ожиданием очередей
+    double utilization() const { return share(totals.busy_ns); }
+};
+
+// Постоянный пул потоков для конвейера: потоки создаются один раз и переиспользуются
+// между запусками. run раздаёт потоки стадиям явно, по StageSpec::threads, так что
+// бюджет потоков делится между стадиями открыто, без вложенных команд OpenMP
+class StagePool {
+public:
+    explicit StagePool(int threads) : generation_(0), active_(0), stopping_(false), tasks_(threads) {
+        for (int t = 0; t < threads; ++t) {
+            workers_.emplace_back([this, t] { worker_loop(t); });
+        }
+    }
+
+    StagePool(const StagePool&) = delete;
+    StagePool& operator=(const StagePool&) = delete;
+
+    ~StagePool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        start_cv_.notify_all();
+        for (std::thread& w : workers_) w.join();
+    }
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    // Запускает стадии и ждёт их завершения; потоков стадий в сумме не больше size()
+    std::vector<StageReport> run(const std::vector<StageSpec>& stages) {
+        std::vector<std::vector<StageCounters>> counters(stages.size());
+        std::vector<int> remaining(stages.size());
+        std::mutex done_mtx;
+
+        // Задачи собираются локально и публикуются под мьютексом вместе с новым поколением:
+        // поток, простаивавший в прошлом запуске, может ещё читать tasks_
+        std::vector<std::function<void()>> tasks(size());
+        int worker = 0;
+        for (size_t s = 0; s < stages.size(); ++s) {
+            counters[s].resize(stages[s].threads);
+            remaining[s] = stages[s].threads;
+            for (int k = 0; k < stages[s].threads; ++k, ++worker) {
+                StageCounters* slot = &counters[s][k];
+                const StageSpec* spec = &stages[s];
+                int* left = &remaining[s];
+                tasks[worker] = [spec, slot, left, &done_mtx, k] {
+                    spec->body(k, *slot);
+                    bool last = false;
+                    {
+                        std::lock_guard<std::mutex> lock(done_mtx);
+                        last = (--*left == 0);
+                    }
+                    if (last && spec->on_done) spec->on_done();
+                };
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            active_ = worker;
+            tasks_.swap(tasks);
+            ++generation_;
+            start_cv_.notify_all();
+            done_cv_.wait(lock, [&] { return active_ == 0; });
+        }
+        const double wall = elapsed_ns(start) / 1e6;
+
+        std::vector<StageReport> reports;
+        for (size_t s = 0; s < stages.size(); ++s) {
+            StageReport r;
+            r.name = stages[s].name;
+            r.threads = stages[s].threads;
+            for (const StageCounters& c : counters[s]) r.totals.add(c);
+            r.wall_ms = wall;
+            reports.push_back(r);
+        }
+        return reports;
+    }
+
+private:
+    void worker_loop(int index) {
+        unsigned long long seen = 0;
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                start_cv_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+                task = tasks_[index];
+            }
+            if (!task) continue;
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (--active_ == 0) done_cv_.notify_all();
+            }
+        }
+    }
+
+    unsigned long long generation_;
+    int active_;
+    bool stopping_;
+    std::vector<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    std::mutex mtx_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+};
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/utsname.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bench.h"
+#include "perf_counters.h"
+
+// Машиночитаемые результаты рядом с текстовым логом: Results/N_log.txt сопровождается
+// Results/N_results.jsonl (одна запись JSON на замер) и Results/N_results.csv с теми же
+// полями. Запись — программа, ядро, параметры, число потоков, статистика BenchStats
+// и метаданные хоста; по ним compare_results сравнивает два набора результатов.
+// Если доступны аппаратные счётчики (perf_counters.h), каждый замер дополняется ещё одним
+// запуском под счётчиками: итоги событий, IPC и промахи на элемент попадают в ту же запись.
+// Считаются потоки команды OpenMP; потоки, которые ядро создаёт само, в счёт не входят
+
+// Откуда получены числа: без этого сравнение двух наборов с разных машин бессмысленно
+struct HostInfo {
+    std::string host;
+    std::string os;
+    std::string arch;
+    int cpus;
+    std::string compiler;
+    std::string openmp;
+    std::string timestamp;   // UTC, ISO 8601
+};
+
+inline HostInfo collect_host_info() {
+    HostInfo info;
+    info.host = host_name();
+    struct utsname u;
+    if (uname(&u) == 0) {
+        info.os = std::string(u.sysname) + " " + u.release;
+        info.arch = u.machine;
+    } else {
+        info.os = "unknown";
+        info.arch = "unknown";
+    }
+    info.cpus = static_cast<int>(std::thread::hardware_concurrency());
+#if defined(__clang__)
+    info.compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    info.compiler = std::string("gcc ") + __VERSION__;
+#else
+    info.compiler = "unknown";
+#endif
+#ifdef _OPENMP
+    info.openmp = std::to_string(_OPENMP) + ", max threads " + std::to_string(omp_get_max_threads());
+#else
+    info.openmp = "none";
+#endif
+    char buf[32] = { 0 };
+    const std::time_t now = std::time(nullptr);
+    std::tm utc;
+    if (gmtime_r(&now, &utc) && std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc) > 0) {
+        info.timestamp = buf;
+    } else {
+        info.timestamp = "unknown";
+    }
+    return info;
+}
+
+// Один замер. params — параметры конфигурации вида "size=100000 schedule=static"
+// (пары через пробел); вместе с program, kernel и threads они задают ключ сравнения
+struct ResultRecord {
+    std::string program;
+    std::string kernel;
+    std::string params;
+    int threads;
+    BenchStats stats;
+    HostInfo host;
+    double elements = 0.0;      // элементов на запуск ядра (для «на элемент»), 0 — не задано
+    CounterSample counters;     // итоги событий, -1 — недоступно
+
+    std::string key() const {
+        return program + " " + kernel + (params.empty() ? "" : " " + params) + " threads=" + std::to_string(threads);
+    }
+};
+
+inline std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+inline std::string csv_field(const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+inline const char* csv_header() {
+    return "program,kernel,params,threads,median_ms,mean_ms,min_ms,max_ms,stddev_ms,ci95_ms,runs,outliers,"
+           "host,os,arch,cpus,compiler,openmp,timestamp,elements,cycles,instructions,llc_misses,branch_misses,"
+           "dtlb_misses,ipc,cycle_imbalance";
+}
+
+// Имена полей счётчиков в .jsonl и .csv, в порядке PerfEvent
+inline const char* counter_field_name(int event) {
+    static const char* names[kPerfEventCount] = { "cycles", "instructions", "llc_misses", "branch_misses",
+                                                  "dtlb_misses" };
+    return names[event];
+}
+
+inline std::string format_json(const ResultRecord& r) {
+    std::ostringstream out;
+    out.precision(9);
+    out << "{\"program\":\"" << json_escape(r.program) << "\",\"kernel\":\"" << json_escape(r.kernel)
+        << "\",\"params\":\"" << json_escape(r.params) << "\",\"threads\":" << r.threads
+        << ",\"median_ms\":" << r.stats.median << ",\"mean_ms\":" << r.stats.mean << ",\"min_ms\":" << r.stats.min
+        << ",\"max_ms\":" << r.stats.max << ",\"stddev_ms\":" << r.stats.stddev << ",\"ci95_ms\":" << r.stats.ci95
+        << ",\"runs\":" << r.stats.runs << ",\"outliers\":" << r.stats.outliers
+        << ",\"host\":\"" << json_escape(r.host.host) << "\",\"os\":\"" << json_escape(r.host.os)
+        << "\",\"arch\":\"" << json_escape(r.host.arch) << "\",\"cpus\":" << r.host.cpus
+        << ",\"compiler\":\"" << json_escape(r.host.compiler) << "\",\"openmp\":\"" << json_escape(r.host.openmp)
+        << "\",\"timestamp\":\"" << json_escape(r.host.timestamp) << "\",\"elements\":" << r.elements;
+    for (int e = 0; e < kPerfEventCount; ++e) out << ",\"" << counter_field_name(e) << "\":" << r.counters.totals[e];
+    out << ",\"ipc\":" << r.counters.ipc() << ",\"cycle_imbalance\":" << r.counters.cycle_imbalance() << "}";
+    return out.str();
+}
+
+inline std::string format_csv(const ResultRecord& r) {
+    std::ostringstream out;
+    out.precision(9);
+    out << csv_field(r.program) << ',' << csv_field(r.kernel) << ',' << csv_field(r.params) << ',' << r.threads << ','
+        << r.stats.median << ',' << r.stats.mean << ',' << r.stats.min << ',' << r.stats.max << ',' << r.stats.stddev
+        << ',' << r.stats.ci95 << ',' << r.stats.runs << ',' << r.stats.outliers << ',' << csv_field(r.host.host)
+        << ',' << csv_field(r.host.os) << ',' << csv_field(r.host.arch) << ',' << r.host.cpus << ','
+        << csv_field(r.host.compiler) << ',' << csv_field(r.host.openmp) << ',' << csv_field(r.host.timestamp)
+        << ',' << r.elements;
+    for (int e = 0; e < kPerfEventCount; ++e) out << ',' << r.counters.totals[e];
+    out << ',' << r.counters.ipc() << ',' << r.counters.cycle_imbalance();
+    return out.str();
+}
+
+// Разбор строки, записанной format_json: плоский объект из строк и чисел.
+// false — строка не похожа на запись результата
+inline bool parse_json_record(const std::string& line, ResultRecord& r) {
+    std::map<std::string, std::string> fields;
+    size_t i = 0;
+    const size_t n = line.size();
+    auto skip_ws = [&] { while (i < n && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')) ++i; };
+    auto read_string = [&](std::string& out) {
+        if (i >= n || line[i] != '"') return false;
+        ++i;
+        out.clear();
+        while (i < n && line[i] != '"') {
+            char c = line[i++];
+            if (c == '\\' && i < n) {
+                c = line[i++];
+                if (c == 'n') c = '\n';
+                else if (c == 't') c = '\t';
+                else if (c == 'u' && i + 4 <= n) {
+                    c = static_cast<char>(std::strtol(line.substr(i, 4).c_str(), nullptr, 16));
+                    i += 4;
+                }
+            }
+            out += c;
+        }
+        if (i >= n) return false;
+        ++i;
+        return true;
+    };
+
+    skip_ws();
+    if (i >= n || line[i++] != '{') return false;
+    while (true) {
+        skip_ws();
+        std::string name, value;
+        if (!read_string(name)) return false;
+        skip_ws();
+        if (i >= n || line[i++] != ':') return false;
+        skip_ws();
+        if (i < n && line[i] == '"') {
+            if (!read_string(value)) return false;
+        } else {
+            const size_t start = i;
+            while (i < n && line[i] != ',' && line[i] != '}' && line[i] != ' ') ++i;
+            value = line.substr(start, i - start);
+        }
+        fields[name] = value;
+        skip_ws();
+        if (i < n && line[i] == ',') { ++i; continue; }
+        if (i < n && line[i] == '}') break;
+        return false;
+    }
+
+    static const char* required[] = { "program", "kernel", "threads", "median_ms", "mean_ms", "stddev_ms", "runs" };
+    for (const char* name : required) {
+        if (!fields.count(name)) return false;
+    }
+    auto number = [&](const char* name) { return fields.count(name) ? std::atof(fields[name].c_str()) : 0.0; };
+    r.program = fields["program"];
+    r.kernel = fields["kernel"];
+    r.params = fields["params"];
+    r.threads = std::atoi(fields["threads"].c_str());
+    r.stats.median = number("median_ms");
+    r.stats.mean = number("mean_ms");
+    r.stats.min = number("min_ms");
+    r.stats.max = number("max_ms");
+    r.stats.stddev = number("stddev_ms");
+    r.stats.ci95 = number("ci95_ms");
+    r.stats.runs = static_cast<int>(number("runs"));
+    r.stats.outliers = static_cast<int>(number("outliers"));
+    r.host.host = fields["host"];
+    r.host.os = fields["os"];
+    r.host.arch = fields["arch"];
+    r.host.cpus = static_cast<int>(number("cpus"));
+    r.host.compiler = fields["compiler"];
+    r.host.openmp = fields["openmp"];
+    r.host.timestamp = fields["timestamp"];
+    // Счётчики необязательны: в записях до их появления полей нет
+    r.elements = number("elements");
+    for (int e = 0; e < kPerfEventCount; ++e) {
+        const char* name = counter_field_name(e);
+        r.counters.totals[e] = fields.count(name) ? std::atoll(fields[name].c_str()) : -1;
+        if (r.counters.totals[e] >= 0) r.counters.available = true;
+    }
+    return true;
+}
+
+// Results/N_log.txt -> Results/N_results (без расширения)
+inline std::string results_base_for(const std::string& log_path) {
+    const std::string suffix = "_log.txt";
+    if (log_path.size() > suffix.size() && log_path.compare(log_path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return log_path.substr(0, log_path.size() - suffix.size()) + "_results";
+    }
+    const size_t dot = log_path.rfind('.');
+    return (dot == std::string::npos ? log_path : log_path.substr(0, dot)) + "_results";
+}
+
+// Пишет замеры программы в .jsonl и .csv. Файлы перезаписываются при каждом запуске,
+// как и текстовый лог; метаданные хоста и доступность счётчиков проверяются один раз при открытии
+class ResultWriter {
+public:
+    ResultWriter(const std::string& program, const std::string& log_path)
+        : program_(program), base_(results_base_for(log_path)), host_(collect_host_info()), elements_(0.0) {}
+
+    bool open() {
+        jsonl_.open(base_ + ".jsonl", std::ios::trunc);
+        csv_.open(base_ + ".csv", std::ios::trunc);
+        if (!jsonl_.is_open() || !csv_.is_open()) {
+            std::cerr << "Ошибка: не удалось открыть " << base_ << ".jsonl / .csv для записи!" << std::endl;
+            return false;
+        }
+        csv_ << csv_header() << "\n";
+        std::cout << "Машиночитаемые результаты: " << base_ << ".jsonl, " << base_ << ".csv" << std::endl;
+        probe_ = count_events(1, [] {});
+        if (!probe_.available) std::cout << "Аппаратные счётчики недоступны: " << probe_.reason << std::endl;
+        last_counters_ = probe_;
+        return true;
+    }
+
+    // Число элементов, которое обрабатывает один запуск ядра в текущей конфигурации
+    // (для «на элемент»); действует на все следующие замеры
+    void set_elements(double elements) { elements_ = elements; }
+
+    bool counters_available() const { return probe_.available; }
+
+    // Счётчики последнего замера для строки лога
+    std::string counters_summary() const { return describe_counters(last_counters_, elements_); }
+
+    void record(const std::string& kernel, const std::string& params, int threads, const BenchStats& stats,
+                const CounterSample& counters = CounterSample()) {
+        ResultRecord r;
+        r.program = program_;
+        r.kernel = kernel;
+        r.params = params;
+        r.threads = threads;
+        r.stats = stats;
+        r.host = host_;
+        r.elements = elements_;
+        r.counters = counters;
+        jsonl_ << format_json(r) << "\n";
+        csv_ << format_csv(r) << "\n";
+        jsonl_.flush();
+        csv_.flush();
+    }
+
+    // run_benchmark с записью результата; возвращает ту же статистику. Счётчики снимаются
+    // отдельным запуском после замера времени, чтобы не влиять на него
+    template <typename Fn>
+    BenchStats measure(const std::string& kernel, const std::string& params, int threads, const Fn& fn,
+                       const BenchOptions& options) {
+        const BenchStats stats = run_benchmark(fn, options);
+        last_counters_ = probe_.available ? count_events(threads, fn) : probe_;
+        record(kernel, params, threads, stats, last_counters_);
+        return stats;
+    }
+
+private:
+    std::string program_;
+    std::string base_;
+    HostInfo host_;
+    double elements_;
+    CounterSample probe_;
+    CounterSample last_counters_;
+    std::ofstream jsonl_;
+    std::ofstream csv_;
+};
@@ -1,29 +1,312 @@
 #include <iostream>
 #include <vector>
 #include <omp.h>
-#include <chrono>
 #include <fstream>
 #include <random>
-#include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <cstddef>
 #include <unistd.h>
 
-void scalar_production(const std::vector<int>& a, const std::vector<int>& b, int num_threads) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DOT_X86 1
+#endif
+
+#include "bench.h"
+#include "results.h"
+
+long long scalar_production(const std::vector<int>& a, const std::vector<int>& b, int num_threads) {
     omp_set_num_threads(num_threads);
-    int result = 0;
+    long long result = 0;
 
     #pragma omp parallel for reduction(+:result)
     for (int i = 0; i < (int)a.size(); ++i) {
-        result += a[i] * b[i];
+        result += static_cast<long long>(a[i]) * b[i];
+    }
+    return result;
+}
+
+// Тип аккумулятора: целые копим в int64 (для int32 точно, пока |сумма| < 2^63),
+// float и double в double
+template <typename T> struct DotTraits;
+template <> struct DotTraits<int8_t>  { typedef int64_t acc_type; static const char* name() { return "int8"; } };
+template <> struct DotTraits<int16_t> { typedef int64_t acc_type; static const char* name() { return "int16"; } };
+template <> struct DotTraits<int32_t> { typedef int64_t acc_type; static const char* name() { return "int32"; } };
+template <> struct DotTraits<float>   { typedef double  acc_type; static const char* name() { return "float"; } };
+template <> struct DotTraits<double>  { typedef double  acc_type; static const char* name() { return "double"; } };
+
+template <typename T>
+typename DotTraits<T>::acc_type dot_scalar(const T* a, const T* b, size_t n) {
+    typedef typename DotTraits<T>::acc_type acc_t;
+    acc_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<acc_t>(a[i]) * static_cast<acc_t>(b[i]);
+    }
+    return sum;
+}
+
+#if defined(DOT_X86)
+__attribute__((target("avx2")))
+inline int64_t hsum_epi64(__m256i v) {
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("avx2")))
+inline double hsum_pd(__m256d v) {
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// Расширяет восемь int32-сумм vpmaddwd до int64 и добавляет к аккумулятору.
+// Единственный случай переполнения vpmaddwd: (-32768)*(-32768)*2 = 2^31,
+// он даёт INT32_MIN, который иначе недостижим, поэтому его правим на +2^32
+__attribute__((target("avx2")))
+inline __m256i accumulate_madd(__m256i acc, __m256i madd) {
+    const __m256i wrapped = _mm256_cmpeq_epi32(madd, _mm256_set1_epi32(std::numeric_limits<int32_t>::min()));
+    const __m256i fix = _mm256_set1_epi64x(1LL << 32);
+    const __m256i lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(madd));
+    const __m256i hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(madd, 1));
+    const __m256i wlo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(wrapped));
+    const __m256i whi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(wrapped, 1));
+    acc = _mm256_add_epi64(acc, _mm256_add_epi64(lo, _mm256_and_si256(wlo, fix)));
+    return _mm256_add_epi64(acc, _mm256_add_epi64(hi, _mm256_and_si256(whi, fix)));
+}
+
+__attribute__((target("avx2")))
+int64_t dot_avx2_int8(const int8_t* a, const int8_t* b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        acc = accumulate_madd(acc, _mm256_madd_epi16(va, vb));
+    }
+    return hsum_epi64(acc) + dot_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+int64_t dot_avx2_int16(const int16_t* a, const int16_t* b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc = accumulate_madd(acc, _mm256_madd_epi16(va, vb));
+    }
+    return hsum_epi64(acc) + dot_scalar(a + i, b + i, n - i);
+}
+
+// vpmuldq перемножает знаковые младшие половины 64-битных лан, поэтому
+// чётные и нечётные элементы обрабатываются отдельно
+__attribute__((target("avx2")))
+int64_t dot_avx2_int32(const int32_t* a, const int32_t* b, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_mul_epi32(va, vb));
+        acc1 = _mm256_add_epi64(acc1, _mm256_mul_epi32(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32)));
+    }
+    return hsum_epi64(_mm256_add_epi64(acc0, acc1)) + dot_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+double dot_avx2_float(const float* a, const float* b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 va = _mm256_loadu_ps(a + i);
+        const __m256 vb = _mm256_loadu_ps(b + i);
+        acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(va)),
+                               _mm256_cvtps_pd(_mm256_castps256_ps128(vb)), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(va, 1)),
+                               _mm256_cvtps_pd(_mm256_extractf128_ps(vb, 1)), acc1);
+    }
+    return hsum_pd(_mm256_add_pd(acc0, acc1)) + dot_scalar(a + i, b + i, n - i);
+}
+
+// Четыре независимых цепочки FMA, чтобы спрятать её латентность
+__attribute__((target("avx2,fma")))
+double dot_avx2_double(const double* a, const double* b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), acc3);
+    }
+    const __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    return hsum_pd(acc) + dot_scalar(a + i, b + i, n - i);
+}
+
+inline bool cpu_has_avx2_fma() {
+    static const bool has = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }();
+    return has;
+}
+
+inline int64_t dot_simd(const int8_t* a, const int8_t* b, size_t n) {
+    return cpu_has_avx2_fma() ? dot_avx2_int8(a, b, n) : dot_scalar(a, b, n);
+}
+inline int64_t dot_simd(const int16_t* a, const int16_t* b, size_t n) {
+    return cpu_has_avx2_fma() ? dot_avx2_int16(a, b, n) : dot_scalar(a, b, n);
+}
+inline int64_t dot_simd(const int32_t* a, const int32_t* b, size_t n) {
+    return cpu_has_avx2_fma() ? dot_avx2_int32(a, b, n) : dot_scalar(a, b, n);
+}
+inline double dot_simd(const float* a, const float* b, size_t n) {
+    return cpu_has_avx2_fma() ? dot_avx2_float(a, b, n) : dot_scalar(a, b, n);
+}
+inline double dot_simd(const double* a, const double* b, size_t n) {
+    return cpu_has_avx2_fma() ? dot_avx2_double(a, b, n) : dot_scalar(a, b, n);
+}
+#else
+// На остальных архитектурах полагаемся на автовекторизацию скалярного цикла
+template <typename T>
+inline typename DotTraits<T>::acc_type dot_simd(const T* a, const T* b, size_t n) {
+    return dot_scalar(a, b, n);
+}
+#endif
+
+template <typename T>
+typename DotTraits<T>::acc_type dot_product(const T* a, const T* b, size_t n, int num_threads) {
+    typedef typename DotTraits<T>::acc_type acc_t;
+    omp_set_num_threads(num_threads);
+    acc_t result = 0;
+
+    // Непрерывный кусок на поток, граница выровнена на 64 байта
+    const size_t align = 64 / sizeof(T);
+    #pragma omp parallel reduction(+:result)
+    {
+        const size_t nt = static_cast<size_t>(omp_get_num_threads());
+        const size_t tid = static_cast<size_t>(omp_get_thread_num());
+        const size_t chunk = ((n + nt - 1) / nt + align - 1) / align * align;
+        const size_t begin = std::min(n, tid * chunk);
+        const size_t end = std::min(n, begin + chunk);
+        if (begin < end) {
+            result = dot_simd(a + begin, b + begin, end - begin);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+typename DotTraits<T>::acc_type dot_product(const std::vector<T>& a, const std::vector<T>& b, int num_threads) {
+    return dot_product(a.data(), b.data(), std::min(a.size(), b.size()), num_threads);
+}
+
+// Кусок запроса, который держим горячим в L2 (половина типичных 256 КБ)
+const size_t kQueryTileBytes = 128 * 1024;
+
+// Скалярные произведения запроса со всеми векторами блока (count x query.size(), row-major).
+// Команда потоков создаётся один раз, каждый поток берёт непрерывный диапазон строк;
+// длинный запрос режется на куски, так что каждый кусок переиспользуется из кэша,
+// а каждый элемент блока читается ровно один раз
+template <typename T>
+std::vector<typename DotTraits<T>::acc_type> dot_product_batch(const std::vector<T>& query, const std::vector<T>& block,
+                                                               int num_threads) {
+    typedef typename DotTraits<T>::acc_type acc_t;
+    const size_t dim = query.size();
+    if (dim == 0) {
+        std::cerr << " Ошибка: размерность вектора запроса равна нулю" << std::endl;
+        return std::vector<acc_t>();
+    }
+    if (block.size() % dim != 0) {
+        std::cerr << " Ошибка: размер блока " << block.size() << " не кратен размерности запроса " << dim << std::endl;
+        return std::vector<acc_t>();
+    }
+    const size_t count = block.size() / dim;
+    const size_t tile = std::max<size_t>(64 / sizeof(T), kQueryTileBytes / sizeof(T));
+    std::vector<acc_t> out(count, 0);
+
+    omp_set_num_threads(num_threads);
+    #pragma omp parallel
+    {
+        const size_t nt = static_cast<size_t>(omp_get_num_threads());
+        const size_t tid = static_cast<size_t>(omp_get_thread_num());
+        const size_t rows = (count + nt - 1) / nt;
+        const size_t r0 = std::min(count, tid * rows);
+        const size_t r1 = std::min(count, r0 + rows);
+
+        for (size_t c0 = 0; c0 < dim; c0 += tile) {
+            const size_t len = std::min(tile, dim - c0);
+            for (size_t r = r0; r < r1; ++r) {
+                out[r] += dot_simd(query.data() + c0, block.data() + r * dim + c0, len);
+            }
+        }
     }
+    return out;
 }
 
-bool directory_exists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+template <typename T>
+std::vector<T> convert_vector(const std::vector<int>& src) {
+    std::vector<T> dst(src.size());
+    for (size_t i = 0; i < src.size(); ++i) {
+        // Значения 0..1000 не помещаются в int8, поэтому для него сворачиваем диапазон
+        dst[i] = (sizeof(T) == 1) ? static_cast<T>(src[i] % 256 - 128) : static_cast<T>(src[i] - 500);
+    }
+    return dst;
 }
 
-bool create_directory(const std::string& path) {
-    return mkdir(path.c_str(), 0755) == 0;
+template <typename T>
+bool benchmark_dot_type(const std::vector<int>& a_src, const std::vector<int>& b_src,
+                        const std::vector<int>& thread_counts, const BenchOptions& bench, ResultWriter& results,
+                        std::ofstream& log_file) {
+    typedef typename DotTraits<T>::acc_type acc_t;
+    const std::vector<T> a = convert_vector<T>(a_src);
+    const std::vector<T> b = convert_vector<T>(b_src);
+
+    // Эталон: скалярный цикл в long double
+    long double reference = 0.0L;
+    for (size_t i = 0; i < a.size(); ++i) {
+        reference += static_cast<long double>(a[i]) * static_cast<long double>(b[i]);
+    }
+
+    const std::string kernel = std::string("dot_") + DotTraits<T>::name();
+    const std::string config = "size=" + std::to_string(a.size());
+    results.set_elements(static_cast<double>(a.size()));
+    double base_time = 0.0;
+    for (int threads : thread_counts) {
+        acc_t result = 0;
+        const double avg_time = results.measure(kernel, config, threads, [&] {
+            result = dot_product(a, b, threads);
+        }, bench).median;
+
+        const long double err = std::fabs(static_cast<long double>(result) - reference);
+        const long double tol = std::is_integral<T>::value ? 0.0L : 1e-9L * std::fabs(reference) + 1e-6L;
+        if (err > tol) {
+            std::cerr << " Ошибка: dot " << DotTraits<T>::name() << " вернул " << result
+                      << ", ожидалось " << static_cast<double>(reference) << std::endl;
+            return false;
+        }
+
+        if (threads == thread_counts.front()) base_time = avg_time;
+        const double speedup = base_time / avg_time;
+        const double efficiency = speedup / threads;
+
+        if (threads == thread_counts.front()) {
+            log_file << "Dot type: " << DotTraits<T>::name() << " (result: " << result << ")\n";
+        }
+        log_file << "  Dot threads " << threads << ": " << avg_time << " ms (speedup: " << speedup
+                 << "x, efficiency: " << efficiency << ")\n";
+    }
+    return true;
 }
 
 int get_available_processors() {
@@ -54,18 +337,7 @@ int main() {
     std::vector<size_t> sizes = { 100000, 1000000, 10000000, 50000000 };
 
     std::string results_dir = "./Results";
-    
-    std::cout << " Проверяем наличие директории Results..." << std::endl;
-    if (!directory_exists(results_dir)) {
-        std::cout << " Создаем директорию Results..." << std::endl;
-        if (!create_directory(results_dir)) {
-            std::cout << "Ошибка: Не удалось создать директорию Results!" << std::endl;
-            return 1;
-        }
-        std::cout << "Директория Results создана успешно" << std::endl;
-    } else {
-        std::cout << " Директория Results уже существует" << std::endl;
-    }
+    if (!ensure_directory(results_dir)) return 1;
 
     std::string log_path = results_dir + "/2_log.txt";
     std::ofstream log_file(log_path);
@@ -77,7 +349,11 @@ int main() {
     
     std::cout << " Файл для записи результатов открыт: " << log_path << std::endl;
 
-    const int num_tests = 3;
+    ResultWriter results("2", log_path);
+    if (!results.open()) return 1;
+
+    const BenchOptions bench = bench_options(3);
+    log_file << "Timing: " << describe_bench_options(bench) << "\n";
     double base_time = 0.0;
     
 
@@ -85,6 +361,8 @@ int main() {
     for (size_t size : sizes) {
         std::cout << "\n🔧 Обрабатываем векторы размером: " << size << std::endl;
         log_file << "Vector size: " << size << "\n";
+        const std::string config = "size=" + std::to_string(size);
+        results.set_elements(static_cast<double>(size));
 
         std::cout << "    Генерируем случайные данные для двух векторов..." << std::endl;
         std::vector<int> a(size), b(size);
@@ -96,14 +374,9 @@ int main() {
 
         std::cout << "     Выполняем базовый замер (1 поток)..." << std::endl;
         {
-            double total_time = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                auto start = std::chrono::high_resolution_clock::now();
-                scalar_production(a, b, 1);
-                auto end = std::chrono::high_resolution_clock::now();
-                total_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            base_time = total_time / num_tests;
+            base_time = results.measure("scalar_production", config, 1, [&] {
+                do_not_optimize(scalar_production(a, b, 1));
+            }, bench).median;
             double speedup = 1.0;
             double efficiency = 1.0;
             log_file << "Threads: 1\n";
@@ -117,14 +390,9 @@ int main() {
 
             std::cout << " Тестируем " << threads << " потоков..." << std::endl;
 
-            double total_time = 0.0;
-            for (int t = 0; t < num_tests; ++t) {
-                auto start = std::chrono::high_resolution_clock::now();
-                scalar_production(a, b, threads);
-                auto end = std::chrono::high_resolution_clock::now();
-                total_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-            double avg_time = total_time / num_tests;
+            double avg_time = results.measure("scalar_production", config, threads, [&] {
+                do_not_optimize(scalar_production(a, b, threads));
+            }, bench).median;
             double speedup = base_time / avg_time;
             double efficiency = speedup / threads;
 
@@ -134,10 +402,58 @@ int main() {
             std::cout << " " << threads << " потоков: "
                       << avg_time << " мс (ускорение: " << speedup << "x)" << std::endl;
         }
+
+        std::cout << "   Тестируем типизированное скалярное произведение..." << std::endl;
+        if (!benchmark_dot_type<int8_t>(a, b, thread_counts, bench, results, log_file) ||
+            !benchmark_dot_type<int16_t>(a, b, thread_counts, bench, results, log_file) ||
+            !benchmark_dot_type<int32_t>(a, b, thread_counts, bench, results, log_file) ||
+            !benchmark_dot_type<float>(a, b, thread_counts, bench, results, log_file) ||
+            !benchmark_dot_type<double>(a, b, thread_counts, bench, results, log_file)) {
+            return 1;
+        }
         log_file << "--------------------------------------\n";
         std::cout << " Векторы размером " << size << " полностью обработаны" << std::endl;
     }
 
+    std::cout << "\n Тестируем пакетное скалярное произведение (один запрос против многих векторов)..." << std::endl;
+    {
+        const size_t dim = 1024;
+        const size_t count = 20000;
+        std::uniform_real_distribution<float> fdist(-1.0f, 1.0f);
+        std::vector<float> query(dim), block(dim * count);
+        for (float& x : query) x = fdist(gen);
+        for (float& x : block) x = fdist(gen);
+
+        log_file << "Batched dot products: query dim = " << dim << ", vectors = " << count << ", type: float\n";
+        const std::string config = "dim=" + std::to_string(dim) + " vectors=" + std::to_string(count);
+        results.set_elements(static_cast<double>(dim) * count);
+        for (int threads : thread_counts) {
+            std::vector<double> batch;
+            const double batch_time = results.measure("dot_batch", config, threads, [&] {
+                batch = dot_product_batch(query, block, threads);
+            }, bench).median;
+
+            // Старый способ: отдельный вызов (и отдельная команда потоков) на каждую пару
+            std::vector<double> pairwise(count);
+            const double pairwise_time = results.measure("dot_pairwise", config, threads, [&] {
+                for (size_t r = 0; r < count; ++r) {
+                    pairwise[r] = dot_product(query.data(), block.data() + r * dim, dim, threads);
+                }
+            }, bench).median;
+
+            double max_diff = 0.0;
+            for (size_t r = 0; r < count; ++r) {
+                max_diff = std::max(max_diff, std::fabs(batch[r] - pairwise[r]));
+            }
+
+            log_file << "  Batch threads " << threads << ": " << batch_time << " ms (pairwise: " << pairwise_time
+                     << " ms, gain: " << pairwise_time / batch_time << "x, max diff: " << max_diff << ")\n";
+            std::cout << " " << threads << " потоков: пакетно " << batch_time << " мс, попарно "
+                      << pairwise_time << " мс" << std::endl;
+        }
+        log_file << "--------------------------------------\n";
+    }
+
     log_file.close();
     std::cout << " Результаты сохранены в файл: " << log_path << std::endl;
     std::cout << " Программа завершена успешно!" << std::endl;
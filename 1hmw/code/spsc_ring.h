@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Ограниченное кольцо одного производителя и одного потребителя из слотов под вектор
+// размерности dim. Быстрый путь без блокировок: производитель двигает только tail_,
+// потребитель только head_, и они лежат на разных кэш-линиях. Если кольцо полно
+// (противодавление) или пусто, сторона засыпает на condition_variable, а не крутится;
+// мьютекс берётся только на этом медленном пути. Проверка флага ожидания после
+// публикации индекса (обе операции seq_cst) исключает потерянное пробуждение
+class VectorRing {
+public:
+    // capacity округляется вверх до степени двойки и не меньше 2: потребитель может
+    // держать один вектор (предыдущий) и при этом не блокировать производителя.
+    // own_slots = false — производитель публикует только внешнюю память, слоты под
+    // векторы не выделяются, и slot_for_write возвращает nullptr
+    VectorRing(size_t capacity, size_t dim, bool own_slots = true)
+        : capacity_(round_up_pow2(std::max<size_t>(capacity, 2))), mask_(capacity_ - 1),
+          stride_((dim + 7) / 8 * 8), storage_(own_slots ? capacity_ * stride_ : 0), views_(capacity_, nullptr),
+          head_(0), tail_(0), closed_(false), producer_waiting_(false), consumer_waiting_(false),
+          producer_waits_(0), consumer_waits_(0) {}
+
+    VectorRing(const VectorRing&) = delete;
+    VectorRing& operator=(const VectorRing&) = delete;
+
+    // Производитель: память свободного слота (ждёт, пока кольцо полно); nullptr, если
+    // кольцо без своих слотов
+    double* slot_for_write() {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_.load(std::memory_order_acquire) == capacity_) {
+            ++producer_waits_;
+            wait_until(producer_waiting_, [&] { return t - head_.load(std::memory_order_seq_cst) < capacity_; });
+        }
+        return storage_.empty() ? nullptr : storage_.data() + (t & mask_) * stride_;
+    }
+
+    // Производитель: публикует вектор. vec — память из slot_for_write или внешняя
+    // (например, отображённый файл), тогда вектор не копируется
+    void publish(const double* vec) {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        views_[t & mask_] = vec;
+        tail_.store(t + 1, std::memory_order_seq_cst);
+        wake_if_waiting(consumer_waiting_);
+    }
+
+    // Производитель: данных больше не будет
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            closed_.store(true, std::memory_order_seq_cst);
+        }
+        cv_.notify_all();
+    }
+
+    // Потребитель: ждёт, пока в кольце окажется больше held векторов или оно закроется;
+    // возвращает число доступных векторов (не больше held — кольцо закрыто и пусто)
+    size_t wait_for_more(size_t held) {
+        const size_t h = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) - h > held || closed_.load(std::memory_order_acquire)) {
+            return tail_.load(std::memory_order_acquire) - h;
+        }
+        ++consumer_waits_;
+        wait_until(consumer_waiting_, [&] {
+            return tail_.load(std::memory_order_seq_cst) - h > held || closed_.load(std::memory_order_seq_cst);
+        });
+        return tail_.load(std::memory_order_acquire) - h;
+    }
+
+    // Потребитель: k-й вектор от головы (k < результата wait_for_more)
+    const double* at(size_t k) const { return views_[(head_.load(std::memory_order_relaxed) + k) & mask_]; }
+
+    // Потребитель: освобождает count векторов от головы
+    void release(size_t count) {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_seq_cst);
+        wake_if_waiting(producer_waiting_);
+    }
+
+    size_t capacity() const { return capacity_; }
+    long long producer_waits() const { return producer_waits_; }
+    long long consumer_waits() const { return consumer_waits_; }
+
+private:
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p *= 2;
+        return p;
+    }
+
+    template <typename Ready>
+    void wait_until(std::atomic<bool>& waiting, const Ready& ready) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        waiting.store(true, std::memory_order_seq_cst);
+        cv_.wait(lock, ready);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void wake_if_waiting(const std::atomic<bool>& waiting) {
+        if (waiting.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            cv_.notify_all();
+        }
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const size_t stride_;
+    std::vector<double> storage_;
+    std::vector<const double*> views_;
+
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    alignas(64) std::atomic<bool> closed_;
+    std::atomic<bool> producer_waiting_;
+    std::atomic<bool> consumer_waiting_;
+    long long producer_waits_;
+    long long consumer_waits_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Файл целиком, отображённый в память только для чтения
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Ошибка: не удалось открыть файл " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            std::cerr << "Ошибка: не удалось получить размер " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << "Ошибка: mmap " << path << " не удался" << std::endl;
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const char*>(p);
+        madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+// Курсор по тексту из чисел, разделённых пробельными символами. Числа с плавающей
+// точкой разбираются std::from_chars, а если стандартная библиотека его для double
+// не поддерживает (нет __cpp_lib_to_chars, как в старых libc++) — через strtod
+// по копии токена, потому что отображённый файл не заканчивается нулём
+class TextCursor {
+public:
+    TextCursor(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+    const char* position() const { return pos_; }
+
+    bool next(int& value) {
+        skip_space();
+        const std::from_chars_result r = std::from_chars(pos_, end_, value);
+        if (r.ec != std::errc()) return false;
+        pos_ = r.ptr;
+        return true;
+    }
+
+    bool next(double& value) {
+        skip_space();
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        const std::from_chars_result r = std::from_chars(pos_, end_, value);
+        if (r.ec != std::errc()) return false;
+        pos_ = r.ptr;
+        return true;
+#else
+        char token[64];
+        size_t len = 0;
+        while (pos_ + len < end_ && len + 1 < sizeof(token) && !is_space(pos_[len])) {
+            token[len] = pos_[len];
+            ++len;
+        }
+        if (len == 0) return false;
+        token[len] = '\0';
+        char* parsed_end = nullptr;
+        value = std::strtod(token, &parsed_end);
+        if (parsed_end != token + len) return false;
+        pos_ += len;
+        return true;
+#endif
+    }
+
+private:
+    static bool is_space(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void skip_space() {
+        while (pos_ < end_ && is_space(*pos_)) ++pos_;
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+// Заголовок "N D" текстового файла векторов
+inline bool read_vector_header(TextCursor& cursor, int& total_vectors, int& vector_dim) {
+    return cursor.next(total_vectors) && cursor.next(vector_dim) && total_vectors >= 0 && vector_dim > 0;
+}
+
+// Разбирает count векторов размерности D подряд в out (count * D чисел)
+inline bool parse_vectors(TextCursor& cursor, int count, int D, double* out) {
+    const size_t total = static_cast<size_t>(count) * D;
+    for (size_t i = 0; i < total; ++i) {
+        if (!cursor.next(out[i])) return false;
+    }
+    return true;
+}
+
+// Границы кусков текста [begin, end) для параллельного разбора: равные доли по байтам,
+// каждая внутренняя граница сдвинута вперёд за ближайший перевод строки, так что
+// ни одно число не разрезается. Возвращает parts + 1 границ (куски могут быть пустыми)
+inline std::vector<const char*> split_at_lines(const char* begin, const char* end, int parts) {
+    std::vector<const char*> bounds(parts + 1, end);
+    bounds[0] = begin;
+    const size_t length = end - begin;
+    for (int c = 1; c < parts; ++c) {
+        const char* p = std::max(bounds[c - 1], begin + length * c / parts);
+        while (p < end && *p != '\n') ++p;
+        bounds[c] = (p < end) ? p + 1 : end;
+    }
+    return bounds;
+}
+
+// Число токенов (чисел) в тексте: позиции, где символ больше пробела идёт после символа
+// не больше пробела (все разделители ' ', '\n', '\r', '\t' меньше или равны ' ', а символы
+// чисел больше). Позиции проверяются независимо, счётчик 32-битный в пределах блока,
+// поэтому цикл векторизуется и считает в несколько раз быстрее разбора
+inline size_t count_numbers(const char* begin, const char* end) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(begin);
+    const size_t n = end - begin;
+    if (n == 0) return 0;
+    size_t count = b[0] > ' ';
+    for (size_t i = 1; i < n;) {
+        const size_t stop = std::min(n, i + 65536);
+        unsigned block = 0;
+        #pragma omp simd reduction(+:block)
+        for (size_t j = i; j < stop; ++j) {
+            block += (b[j] > ' ') & (b[j - 1] <= ' ');
+        }
+        count += block;
+        i = stop;
+    }
+    return count;
+}
+
+// Разбирает первые total чисел текста [begin, end) в out на num_threads потоках.
+// Первый проход считает числа в каждом куске, префиксная сумма даёт смещение куска
+// в out, второй проход разбирает куски независимо прямо на свои места — порядок
+// сохраняется при любой раскладке чисел по строкам. Кусков больше, чем потоков,
+// чтобы выровнять нагрузку. false — чисел меньше total или ошибка разбора
+inline bool parse_numbers_parallel(const char* begin, const char* end, size_t total, int num_threads, double* out) {
+    const int parts = std::max(1, num_threads * 4);
+    const std::vector<const char*> bounds = split_at_lines(begin, end, parts);
+    std::vector<size_t> offsets(parts + 1, 0);
+
+    #pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+    for (int c = 0; c < parts; ++c) {
+        offsets[c + 1] = count_numbers(bounds[c], bounds[c + 1]);
+    }
+    for (int c = 0; c < parts; ++c) offsets[c + 1] += offsets[c];
+    if (offsets[parts] < total) return false;
+
+    bool ok = true;
+    #pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1) reduction(&&:ok)
+    for (int c = 0; c < parts; ++c) {
+        if (offsets[c] >= total) continue;
+        const size_t count = std::min(offsets[c + 1], total) - offsets[c];
+        TextCursor cursor(bounds[c], bounds[c + 1]);
+        for (size_t i = 0; i < count && ok; ++i) {
+            ok = cursor.next(out[offsets[c] + i]);
+        }
+    }
+    return ok;
+}
+
+// Бинарный набор векторов: заголовок, затем векторы подряд с data_offset. offset кратен 4096,
+// stride кратен 8 double, так что каждый вектор при mmap начинается с кэш-линии
+const char kVectorSetMagic[8] = { 'O', 'M', 'P', 'V', 'E', 'C', 'T', 'S' };
+const uint32_t kVectorSetVersion = 1;
+const uint32_t kVectorDtypeFloat64 = 1;
+const uint64_t kVectorSetAlignment = 64;
+const uint64_t kVectorSetDataOffset = 4096;
+
+struct VectorSetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t count;
+    uint64_t dim;
+    uint64_t stride;
+    uint64_t alignment;
+    uint64_t data_offset;
+};
+
+inline VectorSetHeader make_vector_set_header(size_t count, size_t dim) {
+    const size_t per_line = kVectorSetAlignment / sizeof(double);
+    VectorSetHeader h;
+    std::memcpy(h.magic, kVectorSetMagic, sizeof(h.magic));
+    h.version = kVectorSetVersion;
+    h.dtype = kVectorDtypeFloat64;
+    h.count = count;
+    h.dim = dim;
+    h.stride = (dim + per_line - 1) / per_line * per_line;
+    h.alignment = kVectorSetAlignment;
+    h.data_offset = kVectorSetDataOffset;
+    return h;
+}
+
+inline bool is_vector_set_header(const VectorSetHeader& h) {
+    return std::memcmp(h.magic, kVectorSetMagic, sizeof(h.magic)) == 0;
+}
+
+// Пишет набор построчно, векторы порождает row_fn(i, row); false из row_fn прерывает запись
+template <typename RowFn>
+bool write_vector_set(const std::string& path, size_t count, size_t dim, const RowFn& row_fn) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Ошибка: не удалось создать файл " << path << std::endl;
+        return false;
+    }
+    const VectorSetHeader h = make_vector_set_header(count, dim);
+    std::vector<char> header_block(h.data_offset, 0);
+    std::memcpy(header_block.data(), &h, sizeof(h));
+    out.write(header_block.data(), header_block.size());
+
+    std::vector<double> row(h.stride, 0.0);
+    for (size_t i = 0; i < count; ++i) {
+        if (!row_fn(i, row.data())) return false;
+        out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(double));
+    }
+    if (!out) {
+        std::cerr << "Ошибка: запись в " << path << " не удалась" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Текстовый файл "N D" + числа -> бинарный набор
+inline bool convert_text_to_vector_set(const std::string& text_path, const std::string& binary_path) {
+    MappedFile file;
+    if (!file.open(text_path)) return false;
+    TextCursor cursor(file.data(), file.data() + file.size());
+    int count = 0;
+    int dim = 0;
+    if (!read_vector_header(cursor, count, dim)) {
+        std::cerr << "Ошибка: не удалось прочитать заголовок " << text_path << std::endl;
+        return false;
+    }
+    return write_vector_set(binary_path, count, dim, [&](size_t i, double* row) {
+        if (parse_vectors(cursor, 1, dim, row)) return true;
+        std::cerr << "Ошибка: не удалось разобрать вектор " << i << " в файле " << text_path << std::endl;
+        return false;
+    });
+}
+
+// Бинарный набор, отображённый в память: row(i) указывает прямо в отображение, без копий
+class MappedVectorSet {
+public:
+    MappedVectorSet() : data_(nullptr), count_(0), dim_(0), stride_(0) {}
+
+    bool open(const std::string& path) {
+        data_ = nullptr;
+        if (!file_.open(path)) return false;
+        VectorSetHeader h;
+        if (file_.size() < sizeof(h)) {
+            std::cerr << "Ошибка: " << path << " слишком мал для заголовка" << std::endl;
+            return false;
+        }
+        std::memcpy(&h, file_.data(), sizeof(h));
+        if (!is_vector_set_header(h) || h.version != kVectorSetVersion || h.dtype != kVectorDtypeFloat64 ||
+            h.stride < h.dim || h.data_offset % 4096 != 0 ||
+            file_.size() < h.data_offset + h.count * h.stride * sizeof(double)) {
+            std::cerr << "Ошибка: " << path << " не является набором векторов float64 версии "
+                      << kVectorSetVersion << " или обрезан" << std::endl;
+            return false;
+        }
+        data_ = reinterpret_cast<const double*>(file_.data() + h.data_offset);
+        count_ = h.count;
+        dim_ = h.dim;
+        stride_ = h.stride;
+        return true;
+    }
+
+    size_t count() const { return count_; }
+    size_t dim() const { return dim_; }
+    size_t stride() const { return stride_; }
+    const double* row(size_t i) const { return data_ + i * stride_; }
+
+private:
+    MappedFile file_;
+    const double* data_;
+    size_t count_;
+    size_t dim_;
+    size_t stride_;
+};
+
+// Бинарный ли файл: по сигнатуре в начале, а не по расширению
+inline bool is_vector_set_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    VectorSetHeader h;
+    return in.read(reinterpret_cast<char*>(&h), sizeof(h)) && is_vector_set_header(h);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <omp.h>
+
+// Диапазон итераций [begin, end)
+struct IterRange {
+    long long begin;
+    long long end;
+};
+
+// Дек Чейза–Лева фиксированной ёмкости (Lê et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models"). Владелец кладёт и берёт снизу, воры забирают сверху.
+// Делением пополам глубина дека ограничена высотой дерева разбиений (< 64),
+// поэтому расширение буфера не нужно: при переполнении push возвращает false.
+// Ячейки атомарны, чтобы вор, прочитавший уже перезаписанную ячейку, не был гонкой данных —
+// его CAS по top всё равно не пройдёт
+class alignas(64) RangeDeque {
+public:
+    static const long long kCapacity = 64;
+
+    RangeDeque() : top_(0), bottom_(0) {}
+
+    bool push(const IterRange& r) {
+        const long long b = bottom_.load(std::memory_order_relaxed);
+        const long long t = top_.load(std::memory_order_acquire);
+        if (b - t >= kCapacity) return false;
+        store(b, r);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(IterRange& r) {
+        const long long b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        r = load(b);
+        if (t == b) {
+            // Последний элемент: соревнуемся с ворами
+            const bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(IterRange& r) {
+        long long t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const long long b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        r = load(t);
+        return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+private:
+    void store(long long i, const IterRange& r) {
+        Slot& s = slots_[i & (kCapacity - 1)];
+        s.begin.store(r.begin, std::memory_order_relaxed);
+        s.end.store(r.end, std::memory_order_relaxed);
+    }
+
+    IterRange load(long long i) const {
+        const Slot& s = slots_[i & (kCapacity - 1)];
+        return { s.begin.load(std::memory_order_relaxed), s.end.load(std::memory_order_relaxed) };
+    }
+
+    struct Slot {
+        std::atomic<long long> begin;
+        std::atomic<long long> end;
+    };
+
+    // top_ трогают воры, bottom_ — в основном владелец: разные кэш-линии
+    alignas(64) std::atomic<long long> top_;
+    alignas(64) std::atomic<long long> bottom_;
+    Slot slots_[kCapacity];
+};
+
+struct WorkStealStats {
+    long long steals;
+};
+
+// Сумма body(lo, hi) по [begin, end) на num_threads потоках OpenMP с кражей работы.
+// Каждый поток начинает со своей непрерывной части (как schedule(static)); взяв диапазон,
+// он откладывает в свой дек верхние половины, пока не останется не больше grain итераций,
+// и выполняет остаток. Простаивающий поток крадёт у случайной жертвы самую старую, то есть
+// самую крупную, половину и делит её дальше у себя. Выполненные итерации поток копит
+// у себя и списывает с общего счётчика (он нужен только для завершения) одним вызовом,
+// когда его дек опустел — перед кражей или простоем, а не после каждого куска
+template <typename Body>
+double worksteal_sum(long long begin, long long end, int num_threads, long long grain, const Body& body,
+                     WorkStealStats* stats = nullptr) {
+    if (end <= begin) return 0.0;
+    if (grain < 1) grain = 1;
+    std::vector<RangeDeque> deques(num_threads);
+    std::atomic<long long> remaining(end - begin);
+    std::atomic<long long> steals(0);
+    double sum = 0.0;
+
+    #pragma omp parallel num_threads(num_threads) reduction(+:sum)
+    {
+        const int me = omp_get_thread_num();
+        const int nt = omp_get_num_threads();
+        RangeDeque& own = deques[me];
+        uint32_t rng = 2463534242u ^ static_cast<uint32_t>(me * 0x9E3779B9u);
+        long long my_steals = 0;
+        long long done = 0;
+
+        const long long n = end - begin;
+        IterRange r = { begin + n * me / nt, begin + n * (me + 1) / nt };
+        bool have = r.begin < r.end;
+
+        while (true) {
+            if (!have) have = own.pop(r);
+            if (!have && done > 0) {
+                remaining.fetch_sub(done, std::memory_order_acq_rel);
+                done = 0;
+            }
+            if (!have && nt > 1) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                const int start = static_cast<int>(rng % nt);
+                for (int k = 0; k < nt && !have; ++k) {
+                    const int victim = (start + k) % nt;
+                    if (victim != me && deques[victim].steal(r)) {
+                        have = true;
+                        ++my_steals;
+                    }
+                }
+            }
+            if (!have) {
+                if (remaining.load(std::memory_order_acquire) == 0) break;
+                std::this_thread::yield();
+                continue;
+            }
+
+            while (r.end - r.begin > grain) {
+                const long long mid = r.begin + (r.end - r.begin) / 2;
+                if (!own.push({ mid, r.end })) break;
+                r.end = mid;
+            }
+            sum += body(r.begin, r.end);
+            done += r.end - r.begin;
+            have = false;
+        }
+        steals.fetch_add(my_steals, std::memory_order_relaxed);
+    }
+
+    if (stats != nullptr) stats->steals = steals.load();
+    return sum;
+}